@@ -0,0 +1,44 @@
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+
+#include "computron.h"
+
+//source syntax, one statement per line, ';' starts a comment:
+//  loop:   load count      label, mnemonic and a label or address operand
+//          branchZero done
+//  count:  data 5          named data cell with its initial value
+
+struct AssemblyError
+{
+	size_t line{ 0 };
+	std::string message;
+};
+
+//what the optimizer removed
+struct AssemblyStats
+{
+	size_t jumpsThreaded{ 0 }; //branches retargeted past a chain of branches
+	size_t branchesDropped{ 0 }; //branches to the next instruction
+	size_t unreachableDropped{ 0 }; //instructions no path reaches
+	size_t loadsDropped{ 0 }; //loads of the cell just stored
+	size_t cellsPacked{ 0 }; //unused or duplicate constant cells removed
+};
+
+struct AssembledProgram
+{
+	std::vector<int> words; //empty when there are errors
+	std::vector<AssemblyError> errors;
+	bool optimized{ false }; //false when the layout had to stay as written
+	AssemblyStats stats;
+};
+
+//assembles source into words. with optimize set, code that only refers
+//to memory through labels is optimized and laid out with its data packed
+//after it. code using numeric addresses, treating code as data or
+//falling through into data keeps the layout exactly as written.
+AssembledProgram assemble(std::string_view source, bool optimize = true);
+
+//numeric program text as load_from_file reads it, ending in the sentinel
+std::string program_text(const std::vector<int>& words);
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef BATCH_LOADER_H
+#define BATCH_LOADER_H
+
+#include "computron.h"
+
+//one successfully loaded program in a batch
+struct BatchEntry
+{
+	std::string name; //file name, or file#n inside a multi-program file
+	size_t offset{ 0 }; //first word in the arena
+	size_t wordCount{ 0 }; //words read before the sentinel
+};
+
+//a program that failed to load, the rest of the batch is unaffected
+struct BatchError
+{
+	std::string name;
+	std::string message;
+};
+
+//every loaded program image back to back, memorySize words each
+struct ProgramBatch
+{
+	std::vector<int> arena;
+	std::vector<BatchEntry> index;
+	std::vector<BatchError> errors;
+
+	//copies program i into a memory array
+	void image(size_t i, std::array<int, memorySize>& memory) const;
+};
+
+//loads a directory, a glob such as dir/*.txt, or a single file holding
+//several sentinel-terminated programs. files and programs are parsed in
+//parallel on the given number of threads, 0 picks the hardware count.
+ProgramBatch load_batch(const std::string& path, size_t threads = 0);
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef CFG_H
+#define CFG_H
+
+#include "computron.h"
+
+#include <cstdint>
+
+//marks addresses that no block covers
+constexpr size_t noBlock{ SIZE_MAX };
+
+//straight-line run of instructions entered only at its first address
+struct BasicBlock
+{
+	size_t start{ 0 };
+	size_t end{ 0 }; //one past the last instruction
+	std::vector<size_t> successors; //block indices, taken branch first
+	std::vector<size_t> predecessors;
+	bool loopHeader{ false };
+	bool exitsMemory{ false }; //falls through past the last memory word
+};
+
+//natural loop, the header plus every block that reaches a back edge
+struct Loop
+{
+	size_t header{ 0 };
+	std::vector<size_t> blocks; //sorted, includes the header
+};
+
+//control flow graph of the code reachable from the entry address.
+//built from the loaded image, so code written at run time is not seen.
+struct ControlFlowGraph
+{
+	std::vector<BasicBlock> blocks; //sorted by start address
+	std::array<size_t, memorySize> blockOf; //block per address or noBlock
+	std::vector<std::pair<size_t, size_t>> backEdges; //latch to header
+	std::vector<Loop> loops;
+	size_t entry{ 0 }; //index of the entry block
+};
+
+//addresses an instruction can continue at, taken branch first
+std::vector<size_t> successors_of(int word, size_t address);
+
+//splits the reachable image into basic blocks and finds its loops
+ControlFlowGraph build_cfg(const std::array<int, memorySize>& memory, size_t entry = 0);
+
+//graphviz rendering with one box per block, back edges dashed
+std::string cfg_to_dot(const ControlFlowGraph& cfg, const std::array<int, memorySize>& memory);
+
+#endif
@@ -3,7 +3,9 @@
 
 #include <iostream>
 #include <array>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 constexpr size_t memorySize{ 100 };
@@ -17,9 +19,31 @@ enum class Command {
 	branch = 40, branchNeg, branchZero, halt
 };
 
+//why a run stopped
+enum class Termination : uint8_t { halted, faulted, budgetExceeded };
+
+//full register and memory state of a single machine
+struct MachineState
+{
+	std::array<int, memorySize> memory{ 0 };
+	int accumulator{ 0 };
+	size_t instructionCounter{ 0 };
+	int instructionRegister{ 0 };
+	size_t operationCode{ 0 };
+	size_t operand{ 0 };
+	size_t inputIndex{ 0 }; //next unread input
+
+	bool operator==(const MachineState&) const = default;
+};
+
 //Loads file into memory word by word
 void load_from_file(std::array<int, memorySize>& memory, const std::string& filename);
 
+//Loads one sentinel-terminated program from text and advances text past it,
+//false on an unparsable or invalid word or a program larger than memory.
+//the word count is the words stored, up to the failure when it fails
+bool load_from_buffer(std::array<int, memorySize>& memory, std::string_view& text, size_t* const wordCountPtr);
+
 //executes program loaded into memory
 void execute(std::array<int, memorySize>& memory, int* const acPtr,
 	size_t* const icPtr, int* const irPtr,
@@ -27,15 +51,42 @@ void execute(std::array<int, memorySize>& memory, int* const acPtr,
 	const std::vector<int>& inputs
 	);
 
+//executes a single instruction and returns the command that ran
+Command step(std::array<int, memorySize>& memory, int* const acPtr,
+	size_t* const icPtr, int* const irPtr,
+	size_t* const opCodePtr, size_t* const opPtr,
+	const std::vector<int>& inputs, size_t* const inputIndexPtr
+	);
+
+//executes a single instruction on a machine state
+Command step(MachineState& state, const std::vector<int>& inputs);
+
+//maps an opcode to its command, unknown opcodes halt
+Command opCodeToCommand(size_t opCode);
+
 //dump all memory data and register contents into console
 void dump(std::array<int, memorySize>& memory, int* const acPtr,
 	size_t instructionCounter, size_t instructionRegister,
 	size_t operationCode, size_t operand);
 
+//largest report format_dump can produce, with room to spare
+constexpr size_t dumpBufferSize{ 2048 };
+
+//formats the dump report into buffer, which must hold dumpBufferSize
+//characters, and returns its length. the text matches dump() exactly
+size_t format_dump(char* buffer, const std::array<int, memorySize>& memory, int accumulator,
+	size_t instructionCounter, size_t instructionRegister,
+	size_t operationCode, size_t operand);
+
+//writes the dump report to a file descriptor with a single write
+void dump_to_fd(int fd, const std::array<int, memorySize>& memory, int accumulator,
+	size_t instructionCounter, size_t instructionRegister,
+	size_t operationCode, size_t operand);
+
 //check valid word
 bool validWord(int word);
 
 //helper function for dump, prints output
-void output(std::string label, int width, int value, bool sign);
+void output(const std::string& label, int width, int value, bool sign);
 
 #endif
\ No newline at end of file
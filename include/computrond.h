@@ -0,0 +1,93 @@
+#ifndef COMPUTROND_H
+#define COMPUTROND_H
+
+#include "computron.h"
+#include "precompute.h"
+
+#include <cstdint>
+#include <string_view>
+
+//binary protocol spoken over the computrond unix socket. every message is
+//framed by a little-endian u32 byte length. all integers are little-endian.
+//
+//request:  u8 kind, then
+//          runProgram: u32 program id, u16 input count, i32 inputs
+//          runImage:   u16 word count, i32 words, u16 input count, i32 inputs
+//response: u8 status, i32 accumulator, u16 instruction counter,
+//          i32 instruction register, u16 opcode, u16 operand,
+//          i32 memory[memorySize], u16 output count, i32 outputs
+//words are 32 bit because read stores inputs without range checks.
+
+enum class RequestKind : uint8_t { runProgram = 1, runImage = 2 };
+enum class RunStatus : uint8_t { halted, faulted, budgetExceeded, badRequest, outputExceeded };
+
+//default instruction limit for a single request
+constexpr size_t daemonBudget{ 10'000'000 };
+
+//most words a request may print, the count is sent as a u16
+constexpr size_t daemonOutputLimit{ UINT16_MAX };
+
+//final state of a run returned by the daemon
+struct RunResponse
+{
+	RunStatus status{ RunStatus::badRequest };
+	MachineState state;
+	std::vector<int> outputs; //values printed by write
+};
+
+//builds a request for a program preloaded by the daemon
+std::string encode_run_request(uint32_t programId, const std::vector<int>& inputs);
+
+//builds a request carrying its own memory image
+std::string encode_image_request(const std::array<int, memorySize>& memory,
+	const std::vector<int>& inputs);
+
+//serializes and parses responses
+std::string encode_response(const RunResponse& response);
+RunResponse decode_response(std::string_view frame);
+
+//runs a program image to halt, collecting write output. a write past
+//outputLimit words stops the run with outputExceeded, its word not kept.
+RunResponse run_program(const std::array<int, memorySize>& memory,
+	const std::vector<int>& inputs, size_t budget = daemonBudget,
+	size_t outputLimit = SIZE_MAX);
+
+//runs every program up to its first read once, when the daemon loads it
+std::vector<Precomputed> preload_programs(const std::vector<std::array<int, memorySize>>& images);
+
+//decodes one request frame, runs it and returns the response frame.
+//preloaded programs continue from their precomputed state. runs stop at
+//daemonOutputLimit words of output.
+std::string handle_request(const std::vector<Precomputed>& programs,
+	std::string_view request);
+
+//framed socket io, false on end of stream
+bool read_frame(int fd, std::string& frame);
+bool write_frame(int fd, std::string_view frame);
+
+//answers requests on a connected socket until the peer closes it
+void serve_connection(int fd, const std::vector<Precomputed>& programs);
+
+//listens on a unix socket and serves every connection on its own thread
+void serve(const std::string& socketPath, const std::vector<Precomputed>& programs);
+
+//client side of the protocol over one persistent connection
+class DaemonClient
+{
+public:
+	explicit DaemonClient(const std::string& socketPath);
+	~DaemonClient();
+
+	DaemonClient(const DaemonClient&) = delete;
+	DaemonClient& operator=(const DaemonClient&) = delete;
+
+	RunResponse run(uint32_t programId, const std::vector<int>& inputs);
+	RunResponse run(const std::array<int, memorySize>& memory, const std::vector<int>& inputs);
+
+private:
+	RunResponse roundTrip(const std::string& request);
+
+	int fd{ -1 };
+};
+
+#endif
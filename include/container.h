@@ -0,0 +1,60 @@
+#ifndef CONTAINER_H
+#define CONTAINER_H
+
+#include "batch_loader.h"
+
+#include <cstdint>
+
+//single-file store for many program images, read through mmap.
+//
+//layout, little-endian, offsets from the start of the file:
+//  header    magic "CTRNPAK1", u32 version, u32 count, u64 name table
+//            offset, u64 hash table offset, u32 hash slots, u32 reserved
+//  images    count slots of memorySize i32 words, at offset 40
+//  index     count entries of u64 name offset, u32 name length,
+//            u32 word count, u64 image hash
+//  names     name bytes, not terminated
+//  hash      hash slots of u32, program index + 1 or 0 when empty,
+//            open addressing on the hash of the name
+//images sit at fixed offsets, so locating a program never parses anything.
+
+//FNV-1a hash of a memory image, stable across runs and hosts
+uint64_t program_hash(const std::array<int, memorySize>& memory);
+
+//writes every program of a batch into a container file
+void write_container(const std::string& path, const ProgramBatch& batch);
+
+//read-only view of a container file mapped into memory
+class ProgramContainer
+{
+public:
+	explicit ProgramContainer(const std::string& path);
+	~ProgramContainer();
+
+	ProgramContainer(const ProgramContainer&) = delete;
+	ProgramContainer& operator=(const ProgramContainer&) = delete;
+
+	size_t size() const { return count; }
+	std::string_view name(size_t i) const;
+	size_t wordCount(size_t i) const;
+	uint64_t hash(size_t i) const;
+
+	//memorySize words of program i inside the mapping
+	const int32_t* words(size_t i) const;
+
+	//copies program i into a memory array
+	void image(size_t i, std::array<int, memorySize>& memory) const;
+
+	//index of the named program, or size() when absent
+	size_t find(std::string_view name) const;
+
+private:
+	const unsigned char* data{ nullptr };
+	size_t length{ 0 };
+	size_t count{ 0 };
+	size_t hashSlots{ 0 };
+	const unsigned char* index{ nullptr };
+	const uint32_t* hashTable{ nullptr };
+};
+
+#endif
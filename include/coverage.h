@@ -0,0 +1,76 @@
+#ifndef COVERAGE_H
+#define COVERAGE_H
+
+#include "interpreter.h"
+
+#include <atomic>
+#include <bitset>
+#include <memory>
+
+//which addresses ran and which way each branch went
+struct CoverageMap
+{
+	std::bitset<memorySize> executed;
+	std::bitset<memorySize> taken;
+	std::bitset<memorySize> notTaken;
+};
+
+//interpreter observer that fills a coverage map
+struct CoverageObserver : NullObserver
+{
+	explicit CoverageObserver(CoverageMap& map) : map{ map } {}
+
+	void on_fetch(size_t address, int) { map.executed.set(address); }
+	void on_branch(size_t from, size_t, bool wasTaken)
+	{
+		if (wasTaken)
+			map.taken.set(from);
+		else
+			map.notTaken.set(from);
+	}
+
+	CoverageMap& map;
+};
+
+//coverage of every program in a batch, merged from any number of threads
+//with atomic OR so jobs never wait on each other
+class BatchCoverage
+{
+public:
+	explicit BatchCoverage(size_t programs);
+
+	//adds one job's coverage to its program's totals
+	void merge(size_t program, const CoverageMap& map);
+
+	//merged coverage of one program
+	CoverageMap get(size_t program) const;
+
+	size_t size() const { return programs; }
+
+private:
+	static constexpr size_t wordsPerMap{ (memorySize + 63) / 64 };
+	static constexpr size_t wordsPerProgram{ 3 * wordsPerMap };
+
+	size_t programs;
+	std::unique_ptr<std::atomic<uint64_t>[]> bits;
+};
+
+//code and branch directions that no run reached
+struct CoverageReport
+{
+	size_t instructions{ 0 }; //reachable instructions
+	size_t covered{ 0 };
+	size_t directions{ 0 }; //two per conditional branch
+	size_t directionsCovered{ 0 };
+	std::vector<size_t> uncovered; //reachable addresses never executed
+	std::vector<size_t> neverTaken; //conditional branches never taken
+	std::vector<size_t> alwaysTaken; //conditional branches never falling through
+};
+
+//compares coverage against the reachable code of the image
+CoverageReport report_coverage(const std::array<int, memorySize>& image, const CoverageMap& map);
+
+//human-readable summary of a report
+std::string format_coverage(const CoverageReport& report);
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef DEBUGGER_H
+#define DEBUGGER_H
+
+#include "computron.h"
+
+#include <bitset>
+#include <cstdint>
+
+//why the debugger stopped moving
+enum class StopReason { stepped, breakpoint, watchpoint, halted, faulted, budgetExceeded, start };
+
+//interactive debugger with reverse execution. every forward step logs
+//what it overwrites, and a full checkpoint is taken every interval steps.
+//the undo log only covers the steps since the last checkpoint, so going
+//back further restores an earlier checkpoint and replays forward. once
+//checkpointLimit are held every other one is dropped and the interval
+//doubles, so long runs keep a bounded number of them.
+class Debugger
+{
+public:
+	static constexpr size_t checkpointLimit{ 64 };
+
+	Debugger(const std::array<int, memorySize>& image, std::vector<int> inputs,
+		uint64_t checkpointInterval = 256);
+
+	//stop before executing an address or any instruction with an opcode
+	void add_breakpoint(size_t address);
+	void add_opcode_breakpoint(size_t opCode);
+
+	//stop after an instruction writes a memory cell
+	void add_watchpoint(size_t address);
+
+	void clear_breakpoints();
+
+	StopReason step();
+	StopReason continue_run(uint64_t budget = 10'000'000);
+	StopReason reverse_step();
+	StopReason reverse_continue();
+
+	const MachineState& state() const { return current; }
+
+	//instructions completed, a faulting one is not counted
+	uint64_t executed() const { return count; }
+
+	//full checkpoints held, at most checkpointLimit
+	size_t checkpoint_count() const { return checkpoints.size(); }
+
+	//true once the machine halted or faulted
+	bool finished() const { return ended; }
+
+private:
+	//registers and the overwritten cell before one step
+	struct UndoEntry
+	{
+		int accumulator;
+		uint8_t instructionCounter;
+		int instructionRegister;
+		size_t operationCode;
+		size_t operand;
+		size_t inputIndex;
+		uint8_t writeAddress; //0xFF when nothing was written
+		int oldValue;
+	};
+
+	struct Snapshot
+	{
+		uint64_t executed;
+		MachineState state;
+	};
+
+	StopReason forward();
+	void restoreBefore(uint64_t target);
+	bool breaksAt(size_t address) const;
+
+	const std::vector<int> inputs;
+	uint64_t interval;
+	MachineState current;
+	uint64_t count{ 0 };
+	bool ended{ false };
+	bool faultLogged{ false }; //the undo log ends with the faulted instruction
+	StopReason endReason{ StopReason::halted };
+	std::vector<UndoEntry> undoLog;
+	std::vector<Snapshot> checkpoints;
+
+	std::bitset<memorySize> addressBreaks;
+	std::bitset<memorySize> watches;
+	std::array<bool, memorySize> opCodeBreaks{};
+	bool anyStops{ false }; //false keeps continue on its unchecked loop
+};
+
+//line-oriented command loop: s, c, rs, rc, b <address>, bo <opcode>,
+//w <address>, d, r, p and q
+void run_debugger(Debugger& debugger, std::istream& in, std::ostream& out);
+
+#endif
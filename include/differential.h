@@ -0,0 +1,72 @@
+#ifndef DIFFERENTIAL_H
+#define DIFFERENTIAL_H
+
+#include "computron.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+struct Precomputed;
+class TieredEngine;
+
+//how one engine left a program after a budget of instructions
+struct EngineRun
+{
+	Termination termination{ Termination::halted };
+	MachineState state;
+	uint64_t executed{ 0 }; //instructions completed, a fault does not count
+	bool countsExecuted{ true }; //false when the engine cannot report executed
+	std::vector<int> outputs; //words produced by write
+	bool recordsOutputs{ true }; //false when the engine cannot see writes
+};
+
+//an execution engine under test, runs an image for at most budget instructions
+struct Engine
+{
+	const char* name;
+	EngineRun (*run)(const std::array<int, memorySize>& image, const std::vector<int>& inputs, uint64_t budget);
+};
+
+//the step()-based engine every other engine is checked against
+EngineRun run_reference(const std::array<int, memorySize>& image, const std::vector<int>& inputs, uint64_t budget);
+
+//every alternative engine in the tree: the inlined interpreter, the
+//unchecked interpreter, the ssa ir, loop summaries, precomputed prefixes,
+//the expression dag, tiered execution with loop traces, the daemon, the
+//scheduler and the debugger
+const std::vector<Engine>& alternative_engines();
+
+//the alternative engine with a name, throws when there is none
+const Engine& find_engine(std::string_view name);
+
+//runs through engines that keep state between runs, with that state
+//supplied by the caller
+EngineRun run_precomputed_engine(const Precomputed& precomputed, const std::vector<int>& inputs, uint64_t budget);
+EngineRun run_tiered_engine(TieredEngine& engine, const std::array<int, memorySize>& image,
+	const std::vector<int>& inputs, uint64_t budget);
+
+//first point where an engine stops agreeing with the reference
+struct Divergence
+{
+	std::string engine;
+	uint64_t instruction{ 0 }; //index of the first instruction whose result differs
+	size_t address{ 0 }; //where the reference fetched that instruction
+	std::string field; //first field that differs, like "accumulator" or "memory[12]"
+	EngineRun expected; //reference after the instruction
+	EngineRun actual;
+};
+
+//name of the first field that differs between two runs, empty when they agree
+std::string first_difference(const EngineRun& expected, const EngineRun& actual);
+
+//runs the image through the reference and each engine. for every engine
+//that ends differently, bisects on the budget for the first instruction
+//after which the two disagree.
+std::vector<Divergence> compare_engines(const std::array<int, memorySize>& image,
+	const std::vector<int>& inputs, const std::vector<Engine>& engines, uint64_t budget = 1'000'000);
+
+//one line per divergence
+std::string format_divergence(const Divergence& divergence);
+
+#endif
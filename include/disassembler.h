@@ -0,0 +1,28 @@
+#ifndef DISASSEMBLER_H
+#define DISASSEMBLER_H
+
+#include "batch_loader.h"
+#include "computron.h"
+
+//what a memory cell holds as far as the loaded image shows
+enum class CellKind : uint8_t { unused, code, data };
+
+//code is reachable from address 0, data is named by a reachable instruction
+std::array<CellKind, memorySize> classify_cells(const std::array<int, memorySize>& memory);
+
+//largest listing format_listing can produce, with room to spare
+constexpr size_t listingBufferSize{ 10240 };
+
+//formats an annotated listing into buffer, which must hold
+//listingBufferSize characters, and returns its length. each basic block
+//starts with its label, branches name their target label, and cells that
+//are neither code nor data are left out when they hold zero
+size_t format_listing(char* buffer, const std::array<int, memorySize>& memory);
+
+//listing of one image as a string
+std::string disassemble(const std::array<int, memorySize>& memory);
+
+//listings of every program in a batch, each headed by its name
+std::string disassemble_batch(const ProgramBatch& batch);
+
+#endif
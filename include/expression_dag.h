@@ -0,0 +1,74 @@
+#ifndef EXPRESSION_DAG_H
+#define EXPRESSION_DAG_H
+
+#include "computron.h"
+
+#include <cstdint>
+
+//operations of the dag, arithmetic faults when its result leaves the word range
+enum class DagOp : uint8_t { constant, input, add, subtract, multiply, divide };
+
+struct DagNode
+{
+	DagOp op{ DagOp::constant };
+	int value{ 0 }; //the constant, or which input a read takes
+	size_t left{ 0 };
+	size_t right{ 0 };
+};
+
+//a straight-line program as expressions over its inputs. every node
+//comes after its operands, and arithmetic keeps the order the program
+//runs it in, so the first node that faults is the first fault of the run.
+struct ExpressionDag
+{
+	bool built{ false }; //false when the program does not run straight to a halt
+	std::array<int, memorySize> image{ 0 };
+	std::vector<DagNode> nodes;
+	std::vector<size_t> outputs; //node printed by each write
+	std::vector<std::pair<size_t, size_t>> stores; //cell and final node of every cell written
+	size_t accumulator{ 0 }; //final node of the accumulator
+	size_t reads{ 0 };
+	size_t executed{ 0 }; //instructions up to and including the halt
+	size_t halt{ 0 }; //address of the halt
+};
+
+//traces the image from address 0. branches are followed when they do
+//not depend on input; a conditional one that does, a loop or a write
+//into code leaves the dag unbuilt.
+ExpressionDag build_dag(const std::array<int, memorySize>& image);
+
+//a row the batch ran in the interpreter
+struct ScalarRow
+{
+	Termination termination{ Termination::halted };
+	MachineState state;
+	uint64_t executed{ 0 };
+	std::vector<int> outputs;
+};
+
+//results of a batch in columns. a row the dag evaluated halted, and its
+//values sit in one column per store, then the accumulator, then one per
+//write, row r of column c at index c * rows + r.
+struct DagBatchResult
+{
+	size_t rows{ 0 };
+	std::vector<int> columns;
+	std::vector<size_t> scalarIndex; //per row, SIZE_MAX when the dag evaluated it
+	std::vector<ScalarRow> scalar;
+};
+
+//rows evaluated together, sized so a block of every node stays in cache
+constexpr size_t dagBlockRows{ 256 };
+
+//runs the image once per row of inputs. the dag is evaluated one node
+//at a time across a block of rows, in loops the compiler vectorizes,
+//with a fault mask per row. rows that fault, lack inputs or hold inputs
+//outside the word range, and every row of an unbuilt dag, run in the
+//interpreter, so each row ends exactly as run<>() would end it.
+DagBatchResult run_dag_batch(const ExpressionDag& dag, const std::vector<std::vector<int>>& rows, uint64_t budget);
+
+//full machine state, instructions executed and outputs of one row
+Termination batch_row(const ExpressionDag& dag, const DagBatchResult& batch, size_t row,
+	MachineState* const statePtr, uint64_t* const executedPtr, std::vector<int>* const outputsPtr);
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+
+//"00" through "99", two characters per entry
+constexpr std::array<char, 200> digitPairs = []
+{
+	std::array<char, 200> pairs{};
+	for (int i = 0; i < 100; ++i)
+	{
+		pairs[2 * i] = static_cast<char>('0' + i / 10);
+		pairs[2 * i + 1] = static_cast<char>('0' + i % 10);
+	}
+	return pairs;
+}();
+
+//writes value zero-padded to at least width digits, like setw with
+//setfill('0'), and returns the end of the written text
+inline char* format_padded(char* out, unsigned value, int width)
+{
+	//digits are produced two at a time from the back
+	char digits[10];
+	char* p{ digits + sizeof(digits) };
+	while (value >= 100)
+	{
+		p -= 2;
+		std::memcpy(p, &digitPairs[2 * (value % 100)], 2);
+		value /= 100;
+	}
+	if (value >= 10)
+	{
+		p -= 2;
+		std::memcpy(p, &digitPairs[2 * value], 2);
+	}
+	else
+		*--p = static_cast<char>('0' + value);
+
+	const int length{ static_cast<int>(digits + sizeof(digits) - p) };
+	for (int i = length; i < width; ++i)
+		*out++ = '0';
+	std::memcpy(out, p, static_cast<size_t>(length));
+	return out + length;
+}
+
+//writes a sign followed by the zero-padded magnitude, as dump prints words
+inline char* format_word(char* out, int value, int width)
+{
+	*out++ = value < 0 ? '-' : '+';
+	const unsigned magnitude{ value < 0 ? 0u - static_cast<unsigned>(value) : static_cast<unsigned>(value) };
+	return format_padded(out, magnitude, width);
+}
+
+//copies a string literal and returns the end
+template <size_t N>
+inline char* format_literal(char* out, const char (&text)[N])
+{
+	std::memcpy(out, text, N - 1);
+	return out + N - 1;
+}
+
+#endif
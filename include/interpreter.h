@@ -0,0 +1,182 @@
+#ifndef INTERPRETER_H
+#define INTERPRETER_H
+
+#include "computron.h"
+#include "isa.h"
+
+#include <cstdint>
+
+//observer with empty callbacks. an observer type replaces any subset of
+//these, every call is inlined and the null ones compile to nothing.
+struct NullObserver
+{
+	//instruction word fetched from address
+	void on_fetch(size_t, int) {}
+	//value read from a memory cell by write, load or arithmetic
+	void on_mem_read(size_t, int) {}
+	//value stored into a memory cell by read or store
+	void on_mem_write(size_t, int) {}
+	//branch instruction at from continuing at to, taken or not
+	void on_branch(size_t, size_t, bool) {}
+	//instruction at address that faulted, registers are left as fetched
+	void on_fault(size_t, int) {}
+};
+
+//collects the words printed by write, none when outputsPtr is null
+struct OutputObserver : NullObserver
+{
+	explicit OutputObserver(std::vector<int>* const outputsPtr) : outputsPtr{ outputsPtr } {}
+
+	void on_fetch(size_t, int word) { writing = word_info(word).command == Command::write; }
+	void on_mem_read(size_t, int value)
+	{
+		if (writing && outputsPtr)
+			outputsPtr->push_back(value);
+	}
+
+	std::vector<int>* const outputsPtr;
+	bool writing{ false };
+};
+
+//executes the instruction at the instruction counter. returns false on a
+//fault, leaving the counter on the faulting instruction as step() does.
+template <typename Observer>
+inline bool execute_instruction(std::array<int, memorySize>& memory, int* const acPtr,
+	size_t* const icPtr, int* const irPtr,
+	size_t* const opCodePtr, size_t* const opPtr,
+	const std::vector<int>& inputs, size_t* const inputIndexPtr,
+	Command* const commandPtr, Observer& observer)
+{
+	//running off the end of memory faults instead of reading past it
+	const size_t address{ *icPtr };
+	if (address >= memorySize)
+	{
+		observer.on_fault(address, 0);
+		return false;
+	}
+
+	//extract full instruction, opcode, and operand
+	*irPtr = memory[address];
+	*opCodePtr = *irPtr / 100;
+	*opPtr = *irPtr % 100;
+	observer.on_fetch(address, *irPtr);
+
+	const Command command{ decode_opcode(*opCodePtr) };
+	*commandPtr = command;
+
+	//arithmetic result checked before it reaches the accumulator
+	auto arithmetic = [&](long long word)
+	{
+		if (!validWord(static_cast<int>(word)) || word != static_cast<int>(word))
+		{
+			observer.on_fault(address, *irPtr);
+			return false;
+		}
+		*acPtr = static_cast<int>(word);
+		++(*icPtr);
+		return true;
+	};
+
+	switch (command)
+	{
+		case Command::read:
+			if (*inputIndexPtr >= inputs.size())
+			{
+				observer.on_fault(address, *irPtr);
+				return false;
+			}
+			memory[*opPtr] = inputs[*inputIndexPtr]; //write input to mem
+			observer.on_mem_write(*opPtr, memory[*opPtr]);
+			++(*inputIndexPtr);
+			++(*icPtr);
+			return true;
+		case Command::write:
+			observer.on_mem_read(*opPtr, memory[*opPtr]);
+			++(*icPtr);
+			return true;
+		case Command::load:
+			*acPtr = memory[*opPtr]; //write mem to acc
+			observer.on_mem_read(*opPtr, *acPtr);
+			++(*icPtr);
+			return true;
+		case Command::store:
+			memory[*opPtr] = *acPtr; //write acc to mem
+			observer.on_mem_write(*opPtr, *acPtr);
+			++(*icPtr);
+			return true;
+		case Command::add:
+			observer.on_mem_read(*opPtr, memory[*opPtr]);
+			return arithmetic(static_cast<long long>(*acPtr) + memory[*opPtr]);
+		case Command::subtract:
+			observer.on_mem_read(*opPtr, memory[*opPtr]);
+			return arithmetic(static_cast<long long>(*acPtr) - memory[*opPtr]);
+		case Command::multiply:
+			observer.on_mem_read(*opPtr, memory[*opPtr]);
+			return arithmetic(static_cast<long long>(*acPtr) * memory[*opPtr]);
+		case Command::divide:
+			observer.on_mem_read(*opPtr, memory[*opPtr]);
+			if (memory[*opPtr] == 0) //div-by-zero check
+			{
+				observer.on_fault(address, *irPtr);
+				return false;
+			}
+			return arithmetic(static_cast<long long>(*acPtr) / memory[*opPtr]);
+		case Command::branch:
+			*icPtr = *opPtr; //update instruction counter
+			observer.on_branch(address, *icPtr, true);
+			return true;
+		case Command::branchNeg:
+			*acPtr < 0 ? *icPtr = *opPtr : ++(*icPtr); //check negative, then branch
+			observer.on_branch(address, *icPtr, *acPtr < 0);
+			return true;
+		case Command::branchZero:
+			*acPtr == 0 ? *icPtr = *opPtr : ++(*icPtr); //check zero, then branch
+			observer.on_branch(address, *icPtr, *acPtr == 0);
+			return true;
+		default:
+			//halt and unknown opcodes leave the counter in place
+			return true;
+	}
+}
+
+//runs until halt, a fault, or budget instructions. adds the instructions
+//completed to *executedPtr and never throws.
+template <typename Observer>
+inline Termination run(std::array<int, memorySize>& memory, int* const acPtr,
+	size_t* const icPtr, int* const irPtr,
+	size_t* const opCodePtr, size_t* const opPtr,
+	const std::vector<int>& inputs, size_t* const inputIndexPtr,
+	uint64_t budget, uint64_t* const executedPtr, Observer& observer)
+{
+	Command command;
+	for (uint64_t i = 0; i < budget; ++i)
+	{
+		if (!execute_instruction(memory, acPtr, icPtr, irPtr, opCodePtr, opPtr,
+			inputs, inputIndexPtr, &command, observer))
+		{
+			*executedPtr += i;
+			return Termination::faulted;
+		}
+		if (command == Command::halt)
+		{
+			*executedPtr += i + 1;
+			return Termination::halted;
+		}
+	}
+
+	*executedPtr += budget;
+	return Termination::budgetExceeded;
+}
+
+//same on a machine state
+template <typename Observer>
+inline Termination run(MachineState& state, const std::vector<int>& inputs,
+	uint64_t budget, uint64_t* const executedPtr, Observer& observer)
+{
+	return run(state.memory, &state.accumulator,
+		&state.instructionCounter, &state.instructionRegister,
+		&state.operationCode, &state.operand,
+		inputs, &state.inputIndex, budget, executedPtr, observer);
+}
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef ISA_H
+#define ISA_H
+
+#include "computron.h"
+
+#include <cstdint>
+#include <string_view>
+
+//what the operand of an instruction names
+enum class OperandKind : uint8_t { none, data, target };
+
+//instruction properties
+constexpr uint8_t flagReadsMemory{ 1 << 0 };
+constexpr uint8_t flagWritesMemory{ 1 << 1 };
+constexpr uint8_t flagWritesAccumulator{ 1 << 2 };
+constexpr uint8_t flagBranch{ 1 << 3 }; //may continue at the operand
+constexpr uint8_t flagConditional{ 1 << 4 }; //may also fall through
+constexpr uint8_t flagEndsBlock{ 1 << 5 };
+constexpr uint8_t flagMayFault{ 1 << 6 };
+
+//one instruction of the machine
+struct InstructionInfo
+{
+	Command command;
+	size_t opCode;
+	const char* mnemonic;
+	OperandKind operand;
+	uint8_t flags;
+	uint8_t cost; //relative execution cost, 1 for a plain move
+};
+
+//the whole instruction set, the only place opcodes are listed
+constexpr std::array<InstructionInfo, 12> instructionSet{ {
+	{ Command::read, 10, "read", OperandKind::data, flagWritesMemory | flagMayFault, 2 },
+	{ Command::write, 11, "write", OperandKind::data, flagReadsMemory, 2 },
+	{ Command::load, 20, "load", OperandKind::data, flagReadsMemory | flagWritesAccumulator, 1 },
+	{ Command::store, 21, "store", OperandKind::data, flagWritesMemory, 1 },
+	{ Command::add, 30, "add", OperandKind::data, flagReadsMemory | flagWritesAccumulator | flagMayFault, 1 },
+	{ Command::subtract, 31, "subtract", OperandKind::data, flagReadsMemory | flagWritesAccumulator | flagMayFault, 1 },
+	{ Command::divide, 32, "divide", OperandKind::data, flagReadsMemory | flagWritesAccumulator | flagMayFault, 4 },
+	{ Command::multiply, 33, "multiply", OperandKind::data, flagReadsMemory | flagWritesAccumulator | flagMayFault, 2 },
+	{ Command::branch, 40, "branch", OperandKind::target, flagBranch | flagEndsBlock, 1 },
+	{ Command::branchNeg, 41, "branchNeg", OperandKind::target, flagBranch | flagConditional | flagEndsBlock, 1 },
+	{ Command::branchZero, 42, "branchZero", OperandKind::target, flagBranch | flagConditional | flagEndsBlock, 1 },
+	{ Command::halt, 43, "halt", OperandKind::none, flagEndsBlock, 1 },
+} };
+
+//command_info indexes the decode table by command, so every command's
+//value must be its opcode
+static_assert([]
+{
+	for (const InstructionInfo& info : instructionSet)
+		if (info.opCode != static_cast<size_t>(info.command))
+			return false;
+	return true;
+}());
+
+//opcodes below this go through the decode table, the rest halt
+constexpr size_t opCodeCount{ 100 };
+
+//direct decode table built from the instruction set, unknown opcodes get
+//the halt entry because that is how the machine runs them
+constexpr std::array<InstructionInfo, opCodeCount> decodeTable{ []
+{
+	std::array<InstructionInfo, opCodeCount> table{};
+	const InstructionInfo* halt{ nullptr };
+	for (const InstructionInfo& info : instructionSet)
+		if (info.command == Command::halt)
+			halt = &info;
+	table.fill(*halt);
+	for (const InstructionInfo& info : instructionSet)
+		table[info.opCode] = info;
+	return table;
+}() };
+
+//entry for an opcode as the machine decodes it
+constexpr const InstructionInfo& opcode_info(size_t opCode)
+{
+	return decodeTable[opCode < opCodeCount ? opCode : static_cast<size_t>(Command::halt)];
+}
+
+//entry for an instruction word, negative words decode to a huge opcode
+constexpr const InstructionInfo& word_info(int word)
+{
+	return opcode_info(static_cast<size_t>(word / 100));
+}
+
+constexpr Command decode_opcode(size_t opCode)
+{
+	return opcode_info(opCode).command;
+}
+
+//true when the opcode is in the instruction set rather than halting by default
+constexpr bool defined_opcode(size_t opCode)
+{
+	return opCode < opCodeCount && decodeTable[opCode].opCode == opCode;
+}
+
+//entry for a command
+constexpr const InstructionInfo& command_info(Command command)
+{
+	return decodeTable[static_cast<size_t>(command)];
+}
+
+//entry with the given mnemonic, nullptr when there is none
+constexpr const InstructionInfo* find_mnemonic(std::string_view mnemonic)
+{
+	for (const InstructionInfo& info : instructionSet)
+		if (mnemonic == info.mnemonic)
+			return &info;
+	return nullptr;
+}
+
+static_assert(decode_opcode(21) == Command::store && decode_opcode(44) == Command::halt);
+static_assert(!defined_opcode(0) && defined_opcode(43) && command_info(Command::add).opCode == 30);
+static_assert(find_mnemonic("branchNeg")->opCode == 41 && find_mnemonic("jump") == nullptr);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef LOOP_SUMMARY_H
+#define LOOP_SUMMARY_H
+
+#include "computron.h"
+
+#include <cstdint>
+
+//coefficients of the variables at the start of an iteration, memory cells
+//are variables 0 to 99 and the accumulator is variable 100
+using LinearForm = std::vector<std::pair<size_t, long long>>;
+
+//a counted loop: a cycle from its header back to it made of load, store,
+//add, subtract and branch with one conditional branch that leaves it.
+//every cell it changes grows by a sum over cells that change before it,
+//so after k iterations each value is a polynomial in k.
+struct LoopSummary
+{
+	size_t header{ 0 };
+	size_t length{ 0 }; //instructions per iteration
+	size_t test{ 0 }; //address of the conditional branch that leaves
+	size_t latch{ 0 }; //address of the instruction that returns to the header
+	bool exitWhenTaken{ false };
+	LinearForm condition; //accumulator at the test
+	std::vector<LinearForm> results; //every add and subtract, in order
+	std::vector<std::pair<size_t, LinearForm>> steps; //v grows by form, in resolution order
+	std::vector<std::pair<size_t, LinearForm>> derived; //v set to form, never read before
+	size_t degree{ 0 }; //highest polynomial degree, 1 for a plain counter
+};
+
+struct LoopSummaries
+{
+	std::vector<LoopSummary> loops;
+	std::array<size_t, memorySize> loopAt; //summary per header or SIZE_MAX
+};
+
+//finds the counted loops of an image. only verified images without writes
+//into code are summarized, anything else gets no summaries.
+LoopSummaries summarize_loops(const std::array<int, memorySize>& image);
+
+//on the header of loop, applies every whole iteration that neither
+//leaves the loop nor faults in one step and returns how many. the state
+//is left on the header, as after the last instruction of the iteration.
+uint64_t skip_iterations(const LoopSummary& loop, MachineState& state, uint64_t budget);
+
+//runs like run<NullObserver>() on a state loaded from the summarized image,
+//but on reaching a loop header skips every whole iteration that neither
+//leaves the loop nor faults in one step. the last iteration runs in the
+//interpreter, so exits and overflow happen at the exact instruction.
+Termination run_summarized(MachineState& state, const std::vector<int>& inputs, uint64_t budget,
+	uint64_t* const executedPtr, const LoopSummaries& summaries, std::vector<int>* const outputsPtr = nullptr);
+
+#endif
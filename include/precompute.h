@@ -0,0 +1,33 @@
+#ifndef PRECOMPUTE_H
+#define PRECOMPUTE_H
+
+#include "computron.h"
+
+#include <cstdint>
+
+//instructions a load-time run may take before it keeps what it has
+constexpr uint64_t precomputeLimit{ 1'000'000 };
+
+//what an image does on its own before it needs any input. every run of
+//the image goes through exactly this prefix, whatever its inputs.
+struct Precomputed
+{
+	std::array<int, memorySize> image{ 0 };
+	MachineState state; //at the first read, or where the run ended
+	Termination termination{ Termination::budgetExceeded };
+	uint64_t executed{ 0 };
+	std::vector<int> outputs; //words written by the prefix
+	bool complete{ false }; //halted or faulted without reading, every run ends here
+};
+
+//runs the image from address 0 until it would execute its first read,
+//halts, faults or reaches limit instructions
+Precomputed precompute(const std::array<int, memorySize>& image, uint64_t limit = precomputeLimit);
+
+//finishes a run of the image from its precomputed prefix, ending exactly
+//as a run from address 0 with the same budget would. complete programs
+//skip execution, budgets shorter than the prefix run from the start.
+Termination run_precomputed(const Precomputed& precomputed, const std::vector<int>& inputs, uint64_t budget,
+	MachineState* const statePtr, uint64_t* const executedPtr, std::vector<int>* const outputsPtr);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "state_record.h"
+
+//machine state after a number of executed instructions
+struct Checkpoint
+{
+	uint64_t executed{ 0 };
+	MachineState state;
+	size_t outputCount{ 0 }; //outputs produced so far
+};
+
+//everything needed to reproduce a run offline from its program image
+struct RunLog
+{
+	uint64_t programHash{ 0 }; //program_hash of the loaded image
+	std::vector<int> inputs; //inputs consumed by read, in order
+	std::vector<int> outputs; //words produced by write
+	uint64_t executed{ 0 }; //instructions completed
+	Termination termination{ Termination::halted };
+	MachineState final;
+	uint64_t checkpointInterval{ 0 };
+	std::vector<Checkpoint> checkpoints; //one every checkpointInterval instructions
+};
+
+//runs a program, logging inputs, outputs and periodic checkpoints
+RunLog record_run(const std::array<int, memorySize>& image, const std::vector<int>& inputs,
+	uint64_t checkpointInterval = 1000, uint64_t budget = 10'000'000);
+
+//re-executes a logged run, true when every checkpoint, output and the
+//final state match bit for bit
+bool replay_run(const std::array<int, memorySize>& image, const RunLog& log);
+
+//state of a logged run after executed instructions, resumed from the
+//nearest earlier checkpoint
+MachineState seek_run(const std::array<int, memorySize>& image, const RunLog& log, uint64_t executed);
+
+//compact binary log. memory in checkpoints and the final state is stored
+//as the cells that differ from the image, so reading needs the image too
+void write_run_log(std::ostream& out, const RunLog& log, const std::array<int, memorySize>& image);
+RunLog read_run_log(std::istream& in, const std::array<int, memorySize>& image);
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "computron.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+enum class JobStatus { pending, halted, faulted, budgetExceeded };
+
+//result of one scheduled machine, valid once the job is finished
+struct JobResult
+{
+	MachineState state;
+	JobStatus status{ JobStatus::pending };
+	size_t executed{ 0 }; //instructions run, a faulting one is not counted
+	size_t quanta{ 0 }; //time slices received
+	size_t finishOrder{ 0 }; //position in completion order
+};
+
+//round-robin scheduler that runs many machines in fixed instruction
+//quanta on a small pool of worker threads. jobs are picked by stride
+//scheduling, so a job with priority 2 receives twice the instructions
+//of a job with priority 1 while both are runnable.
+class Scheduler
+{
+public:
+	explicit Scheduler(size_t workers, size_t quantum = 1000);
+	~Scheduler();
+
+	Scheduler(const Scheduler&) = delete;
+	Scheduler& operator=(const Scheduler&) = delete;
+
+	//queues a program, budget of 0 means unlimited, returns job id
+	size_t submit(const std::array<int, memorySize>& memory, std::vector<int> inputs,
+		unsigned priority = 1, size_t budget = 0);
+
+	//blocks until every submitted job has finished
+	void wait();
+
+	//result of a finished job
+	const JobResult& result(size_t id) const;
+
+private:
+	struct Job
+	{
+		JobResult result;
+		std::vector<int> inputs;
+		size_t stride{ 0 };
+		size_t pass{ 0 };
+		size_t budget{ 0 };
+	};
+
+	//orders the run queue by lowest pass first
+	struct LaterPass
+	{
+		bool operator()(const Job* a, const Job* b) const { return a->pass > b->pass; }
+	};
+
+	void work();
+	void runQuantum(Job& job);
+
+	const size_t quantum;
+	std::deque<Job> jobs; //stable addresses for queued pointers
+	std::priority_queue<Job*, std::vector<Job*>, LaterPass> runQueue;
+	size_t globalPass{ 0 };
+	size_t unfinished{ 0 };
+	size_t finished{ 0 };
+	bool stopping{ false };
+	mutable std::mutex lock;
+	std::condition_variable workReady;
+	std::condition_variable allDone;
+	std::vector<std::thread> threads;
+};
+
+#endif
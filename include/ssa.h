@@ -0,0 +1,98 @@
+#ifndef SSA_H
+#define SSA_H
+
+#include "computron.h"
+
+#include <cstdint>
+
+//operations of the ir. read, write and arithmetic keep their order in a
+//block because they consume input, print or may fault
+enum class IrOp : uint8_t { constant, read, write, add, subtract, multiply, divide, phi, copy };
+
+//how a block ends
+enum class IrExit : uint8_t { jump, branchNeg, branchZero, halt };
+
+//variable number of the accumulator, memory cells are 0 to 99
+constexpr size_t accumulatorVariable{ memorySize };
+
+//one ssa value, phi operands follow the order of the block's predecessors
+struct IrValue
+{
+	IrOp op{ IrOp::constant };
+	int constant{ 0 };
+	std::vector<size_t> operands;
+	size_t block{ 0 };
+};
+
+//basic block of the lifted program. block 0 holds the initial values and
+//jumps to the entry, every other block covers one block of the cfg.
+struct IrBlock
+{
+	size_t start{ 0 }; //sml addresses covered, empty for block 0
+	size_t end{ 0 };
+	std::vector<size_t> values; //phis first, then in program order
+	std::vector<size_t> predecessors;
+	IrExit exit{ IrExit::jump };
+	size_t condition{ 0 }; //value tested by a conditional exit
+	size_t taken{ 0 }; //jump target or taken branch
+	size_t next{ 0 }; //fall through of a conditional branch
+	std::vector<std::pair<size_t, size_t>> finals; //variable and value at halt
+	bool reachable{ true };
+};
+
+//what the optimizer changed
+struct IrStats
+{
+	size_t copiesPropagated{ 0 };
+	size_t phisRemoved{ 0 };
+	size_t constantsFolded{ 0 };
+	size_t branchesFolded{ 0 };
+	size_t subexpressionsEliminated{ 0 };
+	size_t deadRemoved{ 0 }; //dead values, stores overwritten before use among them
+};
+
+//a program in ssa form. memory cells and the accumulator are variables,
+//so a store is only a new definition and loads become uses
+struct IrProgram
+{
+	bool lifted{ false }; //false when the image cannot be lifted
+	std::array<int, memorySize> image{ 0 };
+	std::vector<IrValue> values;
+	std::vector<IrBlock> blocks;
+	IrStats stats;
+};
+
+//lifts an image with the construction of Braun et al., which needs no
+//dominance frontiers. only verified images without writes into code lift.
+IrProgram lift_to_ssa(const std::array<int, memorySize>& image);
+
+//runs copy propagation, constant folding with branch folding, common
+//subexpression elimination and dead value elimination until none applies
+void optimize_ssa(IrProgram& program);
+
+//executes the ir. halting runs finish with the exact machine state of the
+//sml program; faults, an exhausted budget or an unlifted program rerun
+//the image in the checked interpreter so those states are exact too
+Termination run_ssa(const IrProgram& program, const std::vector<int>& inputs, uint64_t budget,
+	MachineState* const statePtr, uint64_t* const executedPtr, std::vector<int>* const outputsPtr);
+
+//the ir as sml again. every value the code computes gets a cell of its
+//own, constants share a pool, and phis become copies on the edges into
+//their block. code starts at address 0, cells are taken from the top.
+struct LoweredProgram
+{
+	bool lowered{ false }; //false when the ir is not lifted or does not fit in memory
+	std::array<int, memorySize> image{ 0 };
+	size_t codeLength{ 0 };
+};
+
+//lowers the ir to an image that reads the same inputs, writes the same
+//outputs and halts or faults on the same inputs as the original. a halt
+//leaves the accumulator and every cell the original writes as the
+//original leaves them; other cells and instruction counts differ.
+LoweredProgram lower_ssa(const IrProgram& program);
+
+//text form of the ir, one line per value
+std::string format_ir(const IrProgram& program);
+
+#endif
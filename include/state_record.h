@@ -0,0 +1,58 @@
+#ifndef STATE_RECORD_H
+#define STATE_RECORD_H
+
+#include "computron.h"
+
+#include <cstdint>
+
+//final state of one job, as stored in batch result files
+struct StateRecord
+{
+	uint64_t id{ 0 }; //job or program index within the batch
+	Termination termination{ Termination::halted };
+	MachineState state;
+};
+
+//fixed binary record, so record n of a file starts at n * stateRecordSize.
+//little-endian: u64 id, u8 termination, i32 accumulator, u16 instruction
+//counter, i32 instruction register, i32 opcode, i32 operand,
+//i32 memory[memorySize]
+constexpr size_t stateRecordSize{ 8 + 1 + 4 + 2 + 4 + 4 + 4 + 4 * memorySize };
+
+//appends one binary record to a results stream
+void write_state_binary(std::ostream& out, const StateRecord& record);
+
+//reads the next binary record, false at a clean end of stream
+bool read_state_binary(std::istream& in, StateRecord& record);
+
+//appends one record as a single line of JSON (NDJSON)
+void write_state_json(std::ostream& out, const StateRecord& record);
+
+//memory cell whose final value differs from the loaded image
+struct CellChange
+{
+	uint8_t address{ 0 };
+	int value{ 0 };
+};
+
+//cells of memory that differ from image, in address order
+std::vector<CellChange> diff_memory(const std::array<int, memorySize>& image,
+	const std::array<int, memorySize>& memory);
+
+//sparse binary record holding registers and only the changed cells:
+//the registers as in the full record, u8 change count, then
+//count * (u8 address, i32 value)
+void write_diff_binary(std::ostream& out, const StateRecord& record,
+	const std::array<int, memorySize>& image);
+
+//reads a sparse record and rebuilds full memory from the image
+bool read_diff_binary(std::istream& in, const std::array<int, memorySize>& image, StateRecord& record);
+
+//sparse JSON line with "changes":[[address,value],...] instead of memory
+void write_diff_json(std::ostream& out, const StateRecord& record,
+	const std::array<int, memorySize>& image);
+
+//name used for a termination in JSON output
+const char* termination_name(Termination termination);
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef TIERED_H
+#define TIERED_H
+
+#include "computron.h"
+#include "loop_summary.h"
+#include "trace_compiler.h"
+
+#include <bitset>
+#include <cstdint>
+#include <unordered_map>
+
+//how a program runs, each tier cheaper per instruction and dearer to prepare
+enum class Tier : uint8_t { interpreted, decoded, optimized };
+
+//taken backward branches, summed over every run of a program, that
+//promote it to a tier
+struct TierThresholds
+{
+	uint64_t decoded{ 1'000 };
+	uint64_t optimized{ 100'000 };
+	uint64_t trace{ 64 }; //to one loop header, before the optimized tier traces it
+};
+
+//an instruction word decoded once, kept until the word is overwritten
+struct DecodedWord
+{
+	Command command{ Command::halt };
+	size_t operand{ 0 };
+	int word{ 0 };
+};
+
+//what the engine learned about one program
+struct TierProfile
+{
+	std::array<int, memorySize> image{ 0 };
+	Tier tier{ Tier::interpreted };
+	uint64_t runs{ 0 };
+	uint64_t backwardBranches{ 0 };
+	std::array<uint64_t, memorySize> loopCounts{}; //taken backward branches per target
+	std::array<DecodedWord, memorySize> decoded; //the image decoded, from the decoded tier on
+	LoopSummaries summaries; //from the optimized tier on
+	std::vector<Trace> traces; //compiled loop traces
+	std::array<size_t, memorySize> traceAt; //trace entered at each header, SIZE_MAX for none
+	std::bitset<memorySize> traceTried; //headers already recorded
+	std::bitset<memorySize> traced; //words some trace was compiled from
+};
+
+//runs each program in the tier its profile has earned. programs start in
+//the interpreter with a counter on every taken backward branch and are
+//promoted, mid-run included, once the count crosses a threshold. the
+//decoded tier runs pre-decoded words and decodes again any word a store
+//or read overwrites; the optimized tier adds loop summaries and records
+//the path hot loops take into traces, run as superinstructions until a
+//guard sees the path change. a trace whose words a run overwrites is
+//dropped for the rest of that run. every tier ends a run exactly as
+//run<>() does. an engine is not thread-safe.
+class TieredEngine
+{
+public:
+	explicit TieredEngine(TierThresholds thresholds = {});
+
+	//runs the image from a fresh state for at most budget instructions
+	Termination run(const std::array<int, memorySize>& image, const std::vector<int>& inputs, uint64_t budget,
+		MachineState* const statePtr, uint64_t* const executedPtr, std::vector<int>* const outputsPtr = nullptr);
+
+	//profile of an image, nullptr before its first run
+	const TierProfile* profile(const std::array<int, memorySize>& image) const;
+
+private:
+	TierProfile& profileFor(const std::array<int, memorySize>& image);
+	bool interpret(TierProfile& profile, MachineState& state, const std::vector<int>& inputs, uint64_t budget,
+		uint64_t* const donePtr, std::vector<int>* const outputsPtr, Termination* const terminationPtr);
+	template <bool optimized>
+	bool runDecoded(TierProfile& profile, std::array<DecodedWord, memorySize>& code, MachineState& state,
+		const std::vector<int>& inputs, uint64_t budget, uint64_t* const donePtr,
+		std::vector<int>* const outputsPtr, Termination* const terminationPtr);
+	bool recordTrace(TierProfile& profile, MachineState& state, const std::vector<int>& inputs, uint64_t budget,
+		uint64_t* const donePtr, std::vector<int>* const outputsPtr, Termination* const terminationPtr);
+
+	const TierThresholds thresholds;
+	std::unordered_map<uint64_t, TierProfile> profiles; //by program_hash
+};
+
+#endif
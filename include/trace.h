@@ -0,0 +1,82 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "computron.h"
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <thread>
+
+//writeAddress of an instruction that stored nothing
+constexpr uint8_t noWrite{ 0xFF };
+
+//one executed instruction
+struct TraceEntry
+{
+	uint8_t instructionCounter{ 0 };
+	uint8_t writeAddress{ noWrite };
+	bool faulted{ false }; //the instruction threw, registers are unchanged
+	int instructionRegister{ 0 };
+	int accumulatorBefore{ 0 };
+	int accumulatorAfter{ 0 };
+	int writeValue{ 0 };
+};
+
+//encoded size on disk: u8 ic, u8 write address, u8 flags, then i32
+//instruction register, accumulator before and after, and write value
+constexpr size_t traceEntrySize{ 3 + 4 * 4 };
+
+//fixed-size single-producer single-consumer ring, no locks on either side
+class TraceRing
+{
+public:
+	explicit TraceRing(size_t capacity); //rounded up to a power of two
+
+	//false when the ring is full
+	bool push(const TraceEntry& entry);
+
+	//moves up to max entries out, returns how many
+	size_t pop(TraceEntry* out, size_t max);
+
+private:
+	std::unique_ptr<TraceEntry[]> entries;
+	size_t mask;
+	alignas(64) std::atomic<size_t> head{ 0 }; //next slot to write
+	alignas(64) std::atomic<size_t> tail{ 0 }; //next slot to read
+};
+
+//drains a ring into a binary trace file on a background thread
+class TraceRecorder
+{
+public:
+	TraceRecorder(const std::string& filename, size_t capacity = 1 << 16);
+	~TraceRecorder(); //flushes everything recorded so far
+
+	TraceRecorder(const TraceRecorder&) = delete;
+	TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+	//queues an entry, waiting for the writer only when the ring is full
+	void record(const TraceEntry& entry);
+
+private:
+	void flushLoop();
+
+	TraceRing ring;
+	std::ofstream file;
+	std::atomic<bool> stopping{ false };
+	std::thread writer;
+};
+
+//executes like execute() while recording every instruction
+void execute_traced(std::array<int, memorySize>& memory, int* const acPtr,
+	size_t* const icPtr, int* const irPtr,
+	size_t* const opCodePtr, size_t* const opPtr,
+	const std::vector<int>& inputs, TraceRecorder& recorder
+	);
+
+//reads the next entry of a trace file, false at a clean end of stream
+bool read_trace_entry(std::istream& in, TraceEntry& entry);
+
+#endif
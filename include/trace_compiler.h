@@ -0,0 +1,58 @@
+#ifndef TRACE_COMPILER_H
+#define TRACE_COMPILER_H
+
+#include "computron.h"
+
+#include <cstdint>
+
+//longest path a loop iteration may take and still be traced
+constexpr size_t traceLimit{ 64 };
+
+//superinstructions of a trace. load, arithmetic and store runs fuse into
+//one operation; guards check the branch went the way it was recorded.
+enum class TraceOpKind : uint8_t
+{
+	load, store, write, arithmetic,
+	loadArithmetic, arithmeticStore, loadArithmeticStore,
+	guard
+};
+
+struct TraceOp
+{
+	TraceOpKind kind{ TraceOpKind::load };
+	Command command{ Command::halt }; //the arithmetic, or the branch a guard checks
+	bool taken{ false }; //direction a guard expects
+	size_t first{ 0 }; //operands in program order
+	size_t second{ 0 };
+	size_t third{ 0 };
+	size_t address{ 0 }; //first instruction of the operation
+	uint32_t offset{ 0 }; //instructions of the iteration before it
+	int before{ 0 }; //word of the instruction before it
+};
+
+//one iteration of a loop along the path it was seen to take, from its
+//header back to the header
+struct Trace
+{
+	bool compiled{ false }; //false when the path cannot run as a trace
+	size_t header{ 0 };
+	std::vector<size_t> path; //address of every instruction
+	std::vector<int> words; //instruction words the trace was compiled from
+	std::vector<TraceOp> ops;
+	std::vector<size_t> stores; //cells the trace writes
+	int closing{ 0 }; //word of the branch back to the header
+};
+
+//compiles the path of one iteration through memory. a path that reads,
+//halts, does not return to its header or stores into its own code is
+//left uncompiled.
+Trace compile_trace(size_t header, const std::vector<size_t>& path, const std::array<int, memorySize>& memory);
+
+//runs whole iterations from the header while one fits in the budget and
+//returns the instructions executed. a failing guard or an instruction
+//that would fault leaves the trace before that instruction, with every
+//register as the instructions before it left them.
+uint64_t run_trace(const Trace& trace, std::array<int, memorySize>& memory, int* const accumulatorPtr,
+	size_t* const icPtr, int* const wordPtr, uint64_t budget, std::vector<int>* const outputsPtr);
+
+#endif
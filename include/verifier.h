@@ -0,0 +1,38 @@
+#ifndef VERIFIER_H
+#define VERIFIER_H
+
+#include "computron.h"
+
+#include <bitset>
+#include <cstdint>
+
+//why a reachable instruction keeps an image out of the unchecked interpreter
+enum class VerifyError { invalidOpcode, negativeWord, fallsOffMemory };
+
+struct VerifyIssue
+{
+	size_t address{ 0 };
+	VerifyError error{ VerifyError::invalidOpcode };
+};
+
+//what the load-time verifier proved about an image
+struct Verification
+{
+	bool verified{ false }; //no issues, the image may run unchecked
+	std::vector<VerifyIssue> issues;
+	std::bitset<memorySize> code; //instructions reachable from address 0
+	std::bitset<memorySize> codeWrites; //read or store instructions that overwrite code
+};
+
+//checks every instruction reachable from address 0 for a known opcode and
+//a non-negative word, so its operand is a valid address, and that no path
+//falls through past the last memory word
+Verification verify_program(const std::array<int, memorySize>& memory);
+
+//runs like run<NullObserver>() but without per-step validity checks when
+//the image is verified. a flagged write to code, an unverified image or a
+//state outside the verified code hands the run to the checked interpreter.
+Termination run_unchecked(MachineState& state, const std::vector<int>& inputs,
+	uint64_t budget, uint64_t* const executedPtr, const Verification& verification);
+
+#endif
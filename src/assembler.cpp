@@ -0,0 +1,459 @@
+#include "assembler.h"
+#include "format.h"
+#include "isa.h"
+
+#include <cctype>
+#include <charconv>
+#include <unordered_map>
+
+namespace
+{
+	constexpr size_t noStatement{ SIZE_MAX };
+
+	//one source statement, an instruction or a data cell
+	struct Statement
+	{
+		size_t line{ 0 };
+		const InstructionInfo* info{ nullptr }; //nullptr for data
+		std::string symbol; //label operand, empty when absolute
+		int value{ 0 }; //absolute operand, or the data value
+		bool removed{ false };
+	};
+
+	bool identifier(std::string_view text)
+	{
+		if (text.empty() || !(std::isalpha(static_cast<unsigned char>(text[0])) || text[0] == '_'))
+			return false;
+		for (char c : text)
+			if (!(std::isalnum(static_cast<unsigned char>(c)) || c == '_'))
+				return false;
+		return true;
+	}
+
+	bool number(std::string_view text, int* const valuePtr)
+	{
+		if (!text.empty() && text[0] == '+')
+			text.remove_prefix(1);
+		const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), *valuePtr);
+		return error == std::errc{} && end == text.data() + text.size();
+	}
+
+	//the program being assembled and the passes over it
+	class Assembler
+	{
+	public:
+		explicit Assembler(AssembledProgram& result) : result{ result } {}
+
+		void parse(std::string_view source);
+		bool symbolic() const;
+		void optimize();
+		void emit(bool packed);
+
+	private:
+		void error(size_t line, std::string message) { result.errors.push_back({ line, std::move(message) }); }
+
+		size_t target(const Statement& statement) const;
+		size_t nextLive(size_t index) const;
+		bool fallsThrough(const Statement& statement) const;
+		bool labelled(size_t index) const;
+		void remove(size_t index);
+
+		bool threadJumps();
+		bool dropBranchesToNext();
+		bool dropUnreachable();
+		bool dropReloads();
+		void packData();
+
+		AssembledProgram& result;
+		std::vector<Statement> statements;
+		std::unordered_map<std::string, size_t> labels; //label to statement
+	};
+
+	void Assembler::parse(std::string_view source)
+	{
+		std::vector<std::string> pending; //labels waiting for their statement
+		size_t line{ 0 };
+
+		while (!source.empty())
+		{
+			const size_t end{ source.find('\n') };
+			std::string_view text{ source.substr(0, end) };
+			source.remove_prefix(end == std::string_view::npos ? source.size() : end + 1);
+			++line;
+
+			if (const size_t comment{ text.find(';') }; comment != std::string_view::npos)
+				text = text.substr(0, comment);
+
+			std::vector<std::string_view> tokens;
+			for (size_t i = 0; i < text.size();)
+			{
+				while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i])))
+					++i;
+				const size_t start{ i };
+				while (i < text.size() && !std::isspace(static_cast<unsigned char>(text[i])))
+					++i;
+				if (i > start)
+					tokens.push_back(text.substr(start, i - start));
+			}
+
+			//leading labels, then at most one statement
+			size_t token{ 0 };
+			for (; token < tokens.size() && tokens[token].back() == ':'; ++token)
+			{
+				const std::string_view label{ tokens[token].substr(0, tokens[token].size() - 1) };
+				if (!identifier(label) || find_mnemonic(label) || label == "data")
+					error(line, "invalid label '" + std::string(label) + "'");
+				else if (labels.contains(std::string(label)))
+					error(line, "duplicate label '" + std::string(label) + "'");
+				else
+				{
+					labels.emplace(label, statements.size());
+					pending.emplace_back(label);
+				}
+			}
+			if (token == tokens.size())
+				continue;
+			pending.clear();
+
+			Statement statement;
+			statement.line = line;
+			const std::string_view mnemonic{ tokens[token++] };
+			const size_t operands{ tokens.size() - token };
+			if (mnemonic == "data")
+			{
+				if (operands != 1 || !number(tokens[token], &statement.value) || !validWord(statement.value))
+					error(line, "data needs one word between -9999 and 9999");
+			}
+			else if ((statement.info = find_mnemonic(mnemonic)) == nullptr)
+				error(line, "unknown mnemonic '" + std::string(mnemonic) + "'");
+			else if (statement.info->operand == OperandKind::none)
+			{
+				if (operands != 0)
+					error(line, std::string(mnemonic) + " takes no operand");
+			}
+			else if (operands != 1)
+				error(line, std::string(mnemonic) + " needs one operand");
+			else if (identifier(tokens[token]))
+				statement.symbol = tokens[token];
+			else if (!number(tokens[token], &statement.value) || statement.value < 0
+				|| statement.value >= static_cast<int>(memorySize))
+				error(line, "operand must be a label or an address from 0 to 99");
+			statements.push_back(std::move(statement));
+		}
+
+		if (!pending.empty())
+			error(line, "label '" + pending.front() + "' has no statement");
+
+		for (const Statement& statement : statements)
+			if (!statement.symbol.empty() && !labels.contains(statement.symbol))
+				error(statement.line, "undefined label '" + statement.symbol + "'");
+	}
+
+	size_t Assembler::target(const Statement& statement) const
+	{
+		return labels.at(statement.symbol);
+	}
+
+	size_t Assembler::nextLive(size_t index) const
+	{
+		for (++index; index < statements.size(); ++index)
+			if (!statements[index].removed)
+				return index;
+		return noStatement;
+	}
+
+	bool Assembler::fallsThrough(const Statement& statement) const
+	{
+		return !(statement.info->flags & flagEndsBlock) || (statement.info->flags & flagConditional);
+	}
+
+	bool Assembler::labelled(size_t index) const
+	{
+		for (const auto& [label, statement] : labels)
+			if (statement == index)
+				return true;
+		return false;
+	}
+
+	void Assembler::remove(size_t index)
+	{
+		//labels move on to whatever now follows
+		statements[index].removed = true;
+		const size_t next{ nextLive(index) };
+		for (auto& [label, statement] : labels)
+			if (statement == index)
+				statement = next;
+	}
+
+	bool Assembler::symbolic() const
+	{
+		//address 0 must be code, and code must only meet data through labels
+		if (statements.empty() || !statements[0].info)
+			return false;
+
+		for (size_t i = 0; i < statements.size(); ++i)
+		{
+			const Statement& statement = statements[i];
+			if (!statement.info)
+				continue;
+			if (statement.info->operand != OperandKind::none)
+			{
+				if (statement.symbol.empty())
+					return false;
+				const bool codeOperand{ statements[target(statement)].info != nullptr };
+				if (codeOperand != (statement.info->operand == OperandKind::target))
+					return false;
+			}
+			if (fallsThrough(statement) && (i + 1 == statements.size() || !statements[i + 1].info))
+				return false;
+		}
+		return true;
+	}
+
+	bool Assembler::threadJumps()
+	{
+		bool changed{ false };
+		for (Statement& statement : statements)
+		{
+			if (statement.removed || !statement.info || !(statement.info->flags & flagBranch))
+				continue;
+
+			//follow unconditional branches, a chain that loops is left alone
+			std::string symbol{ statement.symbol };
+			std::vector<bool> seen(statements.size(), false);
+			while (true)
+			{
+				const size_t index{ labels.at(symbol) };
+				if (index == noStatement || !statements[index].info
+					|| statements[index].info->command != Command::branch)
+					break;
+				if (seen[index])
+				{
+					symbol = statement.symbol;
+					break;
+				}
+				seen[index] = true;
+				symbol = statements[index].symbol;
+			}
+			if (symbol != statement.symbol)
+			{
+				statement.symbol = symbol;
+				++result.stats.jumpsThreaded;
+				changed = true;
+			}
+		}
+		return changed;
+	}
+
+	bool Assembler::dropBranchesToNext()
+	{
+		bool changed{ false };
+		for (size_t i = 0; i < statements.size(); ++i)
+		{
+			const Statement& statement = statements[i];
+			if (!statement.removed && statement.info && (statement.info->flags & flagBranch)
+				&& target(statement) == nextLive(i))
+			{
+				remove(i);
+				++result.stats.branchesDropped;
+				changed = true;
+			}
+		}
+		return changed;
+	}
+
+	bool Assembler::dropUnreachable()
+	{
+		std::vector<bool> reachable(statements.size(), false);
+		std::vector<size_t> work;
+		if (const size_t entry{ statements[0].removed ? nextLive(0) : 0 }; entry != noStatement)
+			work.push_back(entry);
+
+		while (!work.empty())
+		{
+			const size_t index{ work.back() };
+			work.pop_back();
+			if (index == noStatement || reachable[index] || !statements[index].info)
+				continue;
+			reachable[index] = true;
+
+			const Statement& statement = statements[index];
+			if (statement.info->flags & flagBranch)
+				work.push_back(target(statement));
+			if (fallsThrough(statement))
+				work.push_back(nextLive(index));
+		}
+
+		bool changed{ false };
+		for (size_t i = 0; i < statements.size(); ++i)
+		{
+			if (!statements[i].removed && statements[i].info && !reachable[i])
+			{
+				remove(i);
+				++result.stats.unreachableDropped;
+				changed = true;
+			}
+		}
+		return changed;
+	}
+
+	bool Assembler::dropReloads()
+	{
+		bool changed{ false };
+		for (size_t i = 0; i < statements.size(); ++i)
+		{
+			const Statement& statement = statements[i];
+			if (statement.removed || !statement.info || statement.info->command != Command::store)
+				continue;
+
+			//the accumulator already holds what the load would read
+			const size_t next{ nextLive(i) };
+			if (next != noStatement && statements[next].info && statements[next].info->command == Command::load
+				&& statements[next].symbol == statement.symbol && !labelled(next))
+			{
+				remove(next);
+				++result.stats.loadsDropped;
+				changed = true;
+			}
+		}
+		return changed;
+	}
+
+	void Assembler::packData()
+	{
+		//cells read or written by code that is left
+		std::vector<bool> used(statements.size(), false), written(statements.size(), false);
+		for (const Statement& statement : statements)
+		{
+			if (statement.removed || !statement.info || statement.info->operand != OperandKind::data)
+				continue;
+			used[target(statement)] = true;
+			if (statement.info->flags & flagWritesMemory)
+				written[target(statement)] = true;
+		}
+
+		//constants with equal values share the first cell holding the value
+		std::unordered_map<int, std::string> constants;
+		std::unordered_map<std::string, std::string> renamed;
+		for (const auto& [label, index] : labels)
+		{
+			if (index == noStatement || statements[index].info || !used[index] || written[index])
+				continue;
+			const auto [first, added] = constants.emplace(statements[index].value, label);
+			if (!added && labels.at(first->second) != index)
+			{
+				//keep the cell that comes first so the output is stable
+				if (index < labels.at(first->second))
+				{
+					renamed[first->second] = label;
+					first->second = label;
+				}
+				else
+					renamed[label] = first->second;
+			}
+		}
+		for (Statement& statement : statements)
+		{
+			if (statement.removed || !statement.info)
+				continue;
+			//follow renames until the surviving cell
+			for (auto found = renamed.find(statement.symbol); found != renamed.end(); found = renamed.find(statement.symbol))
+				statement.symbol = found->second;
+		}
+
+		for (size_t i = 0; i < statements.size(); ++i)
+		{
+			if (statements[i].removed || statements[i].info)
+				continue;
+			bool keep{ false };
+			for (const Statement& statement : statements)
+				if (!statement.removed && statement.info && !statement.symbol.empty() && target(statement) == i)
+					keep = true;
+			if (!keep)
+			{
+				statements[i].removed = true;
+				++result.stats.cellsPacked;
+			}
+		}
+	}
+
+	void Assembler::optimize()
+	{
+		//each pass can open chances for the others
+		bool changed{ true };
+		while (changed)
+		{
+			changed = threadJumps();
+			changed |= dropBranchesToNext();
+			changed |= dropUnreachable();
+			changed |= dropReloads();
+		}
+		packData();
+	}
+
+	void Assembler::emit(bool packed)
+	{
+		//code first and data after it, or everything as written
+		std::vector<size_t> order;
+		for (int pass = 0; pass < (packed ? 2 : 1); ++pass)
+			for (size_t i = 0; i < statements.size(); ++i)
+				if (!statements[i].removed && (!packed || (statements[i].info != nullptr) == (pass == 0)))
+					order.push_back(i);
+
+		if (order.size() > memorySize)
+		{
+			error(0, "program needs " + std::to_string(order.size()) + " words, memory holds 100");
+			return;
+		}
+
+		std::vector<size_t> address(statements.size(), noStatement);
+		for (size_t i = 0; i < order.size(); ++i)
+			address[order[i]] = i;
+
+		for (size_t index : order)
+		{
+			const Statement& statement = statements[index];
+			if (!statement.info)
+			{
+				result.words.push_back(statement.value);
+				continue;
+			}
+			const size_t operand{ statement.symbol.empty() ? static_cast<size_t>(statement.value)
+				: address[target(statement)] };
+			result.words.push_back(static_cast<int>(statement.info->opCode * 100
+				+ (statement.info->operand == OperandKind::none ? 0 : operand)));
+		}
+	}
+}
+
+AssembledProgram assemble(std::string_view source, bool optimize)
+{
+	AssembledProgram result;
+	Assembler assembler(result);
+	assembler.parse(source);
+	if (!result.errors.empty())
+		return result;
+
+	result.optimized = optimize && assembler.symbolic();
+	if (result.optimized)
+		assembler.optimize();
+	assembler.emit(result.optimized);
+
+	if (!result.errors.empty())
+		result.words.clear();
+	return result;
+}
+
+std::string program_text(const std::vector<int>& words)
+{
+	std::string text(words.size() * 7 + 7, '\0');
+	char* out{ text.data() };
+	for (int word : words)
+	{
+		out = format_word(out, word, 4);
+		*out++ = '\n';
+	}
+	out = format_literal(out, "-99999\n");
+	text.resize(static_cast<size_t>(out - text.data()));
+	return text;
+}
@@ -0,0 +1,31 @@
+#include "assembler.h"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+
+//usage: computron-asm <source> [-O0]
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 3 || (argc == 3 && std::string(argv[2]) != "-O0"))
+    {
+        std::cerr << "usage: computron-asm <source> [-O0]\n";
+        return 1;
+    }
+
+    std::ifstream file(argv[1], std::ios::binary);
+    if (!file)
+    {
+        std::cerr << argv[1] << ": cannot open\n";
+        return 1;
+    }
+    const std::string source{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+
+    const AssembledProgram program = assemble(source, argc == 2);
+    for (const AssemblyError& error : program.errors)
+        std::cerr << argv[1] << ':' << error.line << ": " << error.message << '\n';
+    if (!program.errors.empty())
+        return 2;
+
+    //numeric program on stdout, ready for load_from_file
+    std::cout << program_text(program.words);
+}
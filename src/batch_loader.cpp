@@ -0,0 +1,171 @@
+#include "batch_loader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+
+#include <fnmatch.h>
+
+namespace
+{
+	//one program to parse, either a whole file or a slice of one
+	struct Task
+	{
+		std::string name{};
+		std::string path{}; //empty when text is already in memory
+		std::string_view text{};
+		size_t wordCount{ 0 };
+		std::string error{};
+	};
+
+	bool readFile(const std::string& path, std::string& contents)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+			return false;
+		contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		return true;
+	}
+
+	//true for a line holding only the -99999 sentinel
+	bool sentinelLine(std::string_view line)
+	{
+		const size_t start{ line.find_first_not_of(" \t") };
+		if (start == std::string_view::npos || line.substr(start, 6) != "-99999")
+			return false;
+		return start + 6 == line.size() || line[start + 6] < '0' || line[start + 6] > '9';
+	}
+
+	//splits a multi-program file after every sentinel line
+	void splitPrograms(const std::string& name, std::string_view text, std::vector<Task>& tasks)
+	{
+		size_t begin{ 0 }, position{ 0 };
+		while (position < text.size())
+		{
+			size_t end{ text.find('\n', position) };
+			end = end == std::string_view::npos ? text.size() : end + 1;
+			if (sentinelLine(text.substr(position, end - position)))
+			{
+				tasks.push_back({ .name = name + "#" + std::to_string(tasks.size()), .text = text.substr(begin, end - begin) });
+				begin = end;
+			}
+			position = end;
+		}
+
+		//a last program may end without a sentinel
+		if (text.find_first_not_of(" \t\r\n", begin) != std::string_view::npos)
+			tasks.push_back({ .name = name + "#" + std::to_string(tasks.size()), .text = text.substr(begin) });
+	}
+
+	//regular files of a directory matching an optional glob, sorted by name
+	std::vector<Task> listFiles(const std::filesystem::path& directory, const std::string& pattern)
+	{
+		std::vector<Task> tasks;
+		for (const auto& entry : std::filesystem::directory_iterator(directory))
+		{
+			const std::string name{ entry.path().filename().string() };
+			if (entry.is_regular_file() && (pattern.empty() || fnmatch(pattern.c_str(), name.c_str(), 0) == 0))
+				tasks.push_back({ .name = name, .path = entry.path().string() });
+		}
+
+		std::sort(tasks.begin(), tasks.end(), [](const Task& a, const Task& b) { return a.name < b.name; });
+		return tasks;
+	}
+}
+
+void ProgramBatch::image(size_t i, std::array<int, memorySize>& memory) const
+{
+	if (i >= index.size())
+		throw std::runtime_error("invalid_input");
+
+	const int* words{ arena.data() + index[i].offset };
+	std::copy(words, words + memorySize, memory.begin());
+}
+
+ProgramBatch load_batch(const std::string& path, size_t threads)
+{
+	//work out which programs the path names
+	std::vector<Task> tasks;
+	std::string contents;
+	const std::filesystem::path fsPath{ path };
+	const std::string filename{ fsPath.filename().string() };
+
+	if (filename.find_first_of("*?[") != std::string::npos)
+	{
+		const std::filesystem::path parent{ fsPath.has_parent_path() ? fsPath.parent_path() : "." };
+		tasks = listFiles(parent, filename);
+	}
+	else if (std::filesystem::is_directory(fsPath))
+		tasks = listFiles(fsPath, "");
+	else if (readFile(path, contents))
+		splitPrograms(filename, contents, tasks);
+	else
+		throw std::runtime_error("invalid_input");
+
+	//every task parses into its own slot of the arena
+	ProgramBatch batch;
+	batch.arena.assign(tasks.size() * memorySize, 0);
+
+	std::atomic<size_t> next{ 0 };
+	auto worker = [&]
+	{
+		std::string fileText;
+		std::array<int, memorySize> memory;
+		for (size_t i = next++; i < tasks.size(); i = next++)
+		{
+			Task& task = tasks[i];
+			if (!task.path.empty())
+			{
+				if (!readFile(task.path, fileText))
+				{
+					task.error = "cannot open file";
+					continue;
+				}
+				task.text = fileText;
+			}
+
+			memory.fill(0);
+			std::string_view text{ task.text };
+			if (!load_from_buffer(memory, text, &task.wordCount))
+				task.error = task.wordCount == memorySize ? "program too long" : "invalid word";
+			else
+				std::copy(memory.begin(), memory.end(), batch.arena.begin() + i * memorySize);
+		}
+	};
+
+	//spread the tasks over the worker threads
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	threads = std::min(threads, std::max<size_t>(tasks.size(), 1));
+
+	std::vector<std::thread> pool;
+	for (size_t i = 1; i < threads; ++i)
+		pool.emplace_back(worker);
+	worker();
+	for (std::thread& thread : pool)
+		thread.join();
+
+	//compact good images to the front and index them in order
+	size_t used{ 0 };
+	for (size_t i = 0; i < tasks.size(); ++i)
+	{
+		if (!tasks[i].error.empty())
+		{
+			batch.errors.push_back({ std::move(tasks[i].name), std::move(tasks[i].error) });
+			continue;
+		}
+
+		if (used != i)
+			std::memcpy(&batch.arena[used * memorySize], &batch.arena[i * memorySize], memorySize * sizeof(int));
+		batch.index.push_back({ std::move(tasks[i].name), used * memorySize, tasks[i].wordCount });
+		used++;
+	}
+	batch.arena.resize(used * memorySize);
+
+	return batch;
+}
@@ -0,0 +1,188 @@
+#include "cfg.h"
+#include "isa.h"
+
+#include <algorithm>
+
+std::vector<size_t> successors_of(int word, size_t address)
+{
+	//negative words decode to a huge opcode and halt
+	const size_t operand{ static_cast<size_t>(word % 100) };
+	switch (word_info(word).command)
+	{
+		case Command::branch:
+			return { operand };
+		case Command::branchNeg:
+		case Command::branchZero:
+			return { operand, address + 1 };
+		case Command::halt:
+			return {};
+		default:
+			return { address + 1 };
+	}
+}
+
+ControlFlowGraph build_cfg(const std::array<int, memorySize>& memory, size_t entry)
+{
+	ControlFlowGraph cfg;
+	cfg.blockOf.fill(noBlock);
+	if (entry >= memorySize)
+		return cfg;
+
+	//find reachable addresses and the leaders that start blocks
+	std::array<bool, memorySize> reachable{}, leader{};
+	std::vector<size_t> work{ entry };
+	leader[entry] = true;
+	reachable[entry] = true;
+	while (!work.empty())
+	{
+		const size_t address{ work.back() };
+		work.pop_back();
+
+		const bool branches{ (word_info(memory[address]).flags & flagEndsBlock) != 0 };
+		for (size_t next : successors_of(memory[address], address))
+		{
+			if (next >= memorySize)
+				continue;
+			if (branches)
+				leader[next] = true;
+			if (!reachable[next])
+			{
+				reachable[next] = true;
+				work.push_back(next);
+			}
+		}
+	}
+
+	//grow a block from every leader up to its terminator or the next leader
+	for (size_t address = 0; address < memorySize; ++address)
+	{
+		if (!reachable[address] || !leader[address])
+			continue;
+
+		BasicBlock block;
+		block.start = address;
+		size_t end{ address };
+		while (true)
+		{
+			cfg.blockOf[end] = cfg.blocks.size();
+			const bool terminator{ (word_info(memory[end]).flags & flagEndsBlock) != 0 };
+			++end;
+			if (terminator || end == memorySize || leader[end])
+				break;
+		}
+		block.end = end;
+		cfg.blocks.push_back(block);
+	}
+
+	//connect blocks through the successors of their last instruction
+	for (size_t i = 0; i < cfg.blocks.size(); ++i)
+	{
+		BasicBlock& block = cfg.blocks[i];
+		for (size_t next : successors_of(memory[block.end - 1], block.end - 1))
+		{
+			if (next >= memorySize)
+			{
+				block.exitsMemory = true;
+				continue;
+			}
+			const size_t target{ cfg.blockOf[next] };
+			if (std::find(block.successors.begin(), block.successors.end(), target) == block.successors.end())
+			{
+				block.successors.push_back(target);
+				cfg.blocks[target].predecessors.push_back(i);
+			}
+		}
+	}
+	cfg.entry = cfg.blockOf[entry];
+
+	//depth-first search, an edge back onto the stack closes a loop
+	std::vector<int> color(cfg.blocks.size(), 0); //0 new, 1 on stack, 2 done
+	std::vector<std::pair<size_t, size_t>> stack{ { cfg.entry, 0 } };
+	color[cfg.entry] = 1;
+	while (!stack.empty())
+	{
+		auto& [block, edge] = stack.back();
+		if (edge == cfg.blocks[block].successors.size())
+		{
+			color[block] = 2;
+			stack.pop_back();
+			continue;
+		}
+
+		const size_t next{ cfg.blocks[block].successors[edge++] };
+		if (color[next] == 1)
+		{
+			cfg.backEdges.emplace_back(block, next);
+			cfg.blocks[next].loopHeader = true;
+		}
+		else if (color[next] == 0)
+		{
+			color[next] = 1;
+			stack.emplace_back(next, 0);
+		}
+	}
+
+	//natural loops, walking predecessors back from each latch to the header
+	for (const auto& [latch, header] : cfg.backEdges)
+	{
+		auto loop = std::find_if(cfg.loops.begin(), cfg.loops.end(), [&](const Loop& l) { return l.header == header; });
+		if (loop == cfg.loops.end())
+		{
+			cfg.loops.push_back({ header, { header } });
+			loop = cfg.loops.end() - 1;
+		}
+
+		std::vector<size_t> pending{ latch };
+		while (!pending.empty())
+		{
+			const size_t block{ pending.back() };
+			pending.pop_back();
+			if (std::find(loop->blocks.begin(), loop->blocks.end(), block) != loop->blocks.end())
+				continue;
+			loop->blocks.push_back(block);
+			for (size_t previous : cfg.blocks[block].predecessors)
+				pending.push_back(previous);
+		}
+	}
+	for (Loop& loop : cfg.loops)
+		std::sort(loop.blocks.begin(), loop.blocks.end());
+
+	return cfg;
+}
+
+std::string cfg_to_dot(const ControlFlowGraph& cfg, const std::array<int, memorySize>& memory)
+{
+	std::string dot{ "digraph cfg {\n\tnode [shape=box, fontname=monospace];\n" };
+
+	//one left-aligned line per instruction inside each block
+	for (size_t i = 0; i < cfg.blocks.size(); ++i)
+	{
+		const BasicBlock& block = cfg.blocks[i];
+		dot += "\tb" + std::to_string(i) + " [label=\"";
+		for (size_t address = block.start; address < block.end; ++address)
+		{
+			const int word{ memory[address] };
+			const InstructionInfo& info = word_info(word);
+			dot += (address < 10 ? "0" : "") + std::to_string(address) + ": " + info.mnemonic;
+			if (info.operand != OperandKind::none)
+				dot += " " + std::to_string(word % 100);
+			dot += "\\l";
+		}
+		dot += "\"";
+		if (block.loopHeader)
+			dot += ", peripheries=2";
+		dot += "];\n";
+	}
+
+	for (size_t i = 0; i < cfg.blocks.size(); ++i)
+	{
+		for (size_t next : cfg.blocks[i].successors)
+		{
+			const bool back{ std::find(cfg.backEdges.begin(), cfg.backEdges.end(), std::make_pair(i, next)) != cfg.backEdges.end() };
+			dot += "\tb" + std::to_string(i) + " -> b" + std::to_string(next) + (back ? " [style=dashed];\n" : ";\n");
+		}
+	}
+
+	dot += "}\n";
+	return dot;
+}
@@ -1,63 +1,121 @@
 #include "computron.h"
+#include "format.h"
+#include "interpreter.h"
 
 #include <fstream>
 #include <iomanip>
+#include <iterator>
 
-void load_from_file(std::array<int, memorySize>& memory, const std::string& filename)
+#include <unistd.h>
+
+namespace
+{
+	//parses one line like std::stoi: leading blanks, optional sign, digits
+	bool parseLine(std::string_view line, int* valuePtr)
+	{
+		size_t i{ 0 };
+		while (i < line.size() && (line[i] == ' ' || line[i] == '\t'))
+			i++;
+
+		bool negative{ false };
+		if (i < line.size() && (line[i] == '+' || line[i] == '-'))
+			negative = line[i++] == '-';
+
+		//any digits past the word range only need to stay above it
+		const size_t first{ i };
+		long long value{ 0 };
+		for (; i < line.size() && line[i] >= '0' && line[i] <= '9'; i++)
+			if (value <= maxWord * 100LL)
+				value = value * 10 + (line[i] - '0');
+
+		if (i == first)
+			return false;
+
+		*valuePtr = static_cast<int>(negative ? -value : value);
+		return true;
+	}
+}
+
+bool load_from_buffer(std::array<int, memorySize>& memory, std::string_view& text, size_t* const wordCountPtr)
 {
-	//set vars
 	constexpr int sentinel{ -99999 };
 	size_t i{ 0 };
-	std::string line;
-	int instruction;
 
-	//open file and check open
-	std::ifstream inputFile(filename);
-	if (!inputFile)
+	while (!text.empty())
 	{
-		throw std::runtime_error("invalid_input");
-	}
+		//split off the next line
+		const size_t end{ text.find('\n') };
+		const std::string_view line{ text.substr(0, end) };
+		text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
 
-	//get each line
-	while (std::getline(inputFile, line))
-	{
 		//extract instruction and check for sentinel
-		instruction = std::stoi(line);
+		int instruction;
+		if (!parseLine(line, &instruction))
+		{
+			*wordCountPtr = i;
+			return false;
+		}
 		if (instruction == sentinel)
 			break;
 
-		//add valid words to memory, exit if invalid word
-		if (validWord(instruction))
+		//add valid words to memory, fail on invalid word or full memory
+		if (!validWord(instruction) || i == memorySize)
 		{
-			memory[i] = instruction;
-			i++;
+			*wordCountPtr = i;
+			return false;
 		}
-		else
-			throw std::runtime_error("invalid_input");
+		memory[i] = instruction;
+		i++;
 	}
 
-	inputFile.close();
+	*wordCountPtr = i;
+	return true;
 }
 
-Command opCodeToCommand(size_t opCode)
+void load_from_file(std::array<int, memorySize>& memory, const std::string& filename)
 {
-	//return relevant enum element for each opcode
-	switch (opCode)
+	//open file and check open
+	std::ifstream inputFile(filename, std::ios::binary);
+	if (!inputFile)
 	{
-		case 10: return Command::read; break;
-		case 11: return Command::write; break;
-		case 20: return Command::load; break;
-		case 21: return Command::store; break;
-		case 30: return Command::add; break;
-		case 31: return Command::subtract; break;
-		case 32: return Command::divide; break;
-		case 33: return Command::multiply; break;
-		case 40: return Command::branch; break;
-		case 41: return Command::branchNeg; break;
-		case 42: return Command::branchZero; break;
-		case 43: return Command::halt; break;
-		default: return Command::halt;
+		throw std::runtime_error("invalid_input");
 	}
+
+	//read the whole file at once and parse it
+	const std::string contents{ std::istreambuf_iterator<char>(inputFile), std::istreambuf_iterator<char>() };
+	std::string_view text{ contents };
+	size_t wordCount;
+	if (!load_from_buffer(memory, text, &wordCount))
+		throw std::runtime_error("invalid_input");
+}
+
+Command opCodeToCommand(size_t opCode)
+{
+	//direct lookup in the table generated from the instruction set
+	return decode_opcode(opCode);
+}
+
+Command step(std::array<int, memorySize>& memory, int* const acPtr,
+	size_t* const icPtr, int* const irPtr,
+	size_t* const opCodePtr, size_t* const opPtr,
+	const std::vector<int>& inputs, size_t* const inputIndexPtr)
+{
+	//one instruction through the shared interpreter, faults become exceptions
+	NullObserver observer;
+	Command command;
+	if (!execute_instruction(memory, acPtr, icPtr, irPtr, opCodePtr, opPtr,
+		inputs, inputIndexPtr, &command, observer))
+		throw std::runtime_error("invalid_input");
+
+	return command;
+}
+
+Command step(MachineState& state, const std::vector<int>& inputs)
+{
+	return step(state.memory, &state.accumulator,
+		&state.instructionCounter, &state.instructionRegister,
+		&state.operationCode, &state.operand,
+		inputs, &state.inputIndex);
 }
 
 void execute(std::array<int, memorySize>& memory, int* const acPtr,
@@ -66,143 +124,99 @@ void execute(std::array<int, memorySize>& memory, int* const acPtr,
 	const std::vector<int>& inputs)
 {
 	size_t inputIndex{ 0 }; //Tracks input
+	uint64_t executed{ 0 };
+	NullObserver observer;
 
-	do
-	{
-		//extract full instruction, opcode, and operand
-		*irPtr = memory[*icPtr];
-		*opCodePtr = *irPtr / 100;
-		*opPtr = *irPtr % 100;
-
-		//switch based on opcode
-		switch (int word{}; opCodeToCommand(*opCodePtr))
-		{
-			case Command::read:
-				if (inputIndex < inputs.size())
-				{
-					word = inputs[inputIndex]; //read input
-				}
-				else
-					throw std::runtime_error("invalid_input");
-				memory[*opPtr] = word; //write to mem
-				++(*icPtr); 
-				inputIndex++;
-				break;
-			case Command::write:
-				++(*icPtr); 
-				//std::cout << "Contents of " << std::setfill('0') << std::setw(4);
-				//std::cout << *opPtr << " : " << memory[*opPtr] << "\n";
-				break;
-			case Command::load:
-				*acPtr = memory[*opPtr]; //write mem to acc
-				++(*icPtr);
-				break;
-			case Command::store:
-				memory[*opPtr] = *acPtr; //write acc to mem
-				++(*icPtr);
-				break;
-			case Command::add:
-				word = *acPtr + memory[*opPtr]; //do operation
-				if (validWord(word)) //check valid & write acc
-				{
-					*acPtr = word;
-					++(*icPtr);
-				}
-				else
-					throw std::runtime_error("invalid_input");
-				break;
-			case Command::subtract:
-				word = *acPtr - memory[*opPtr]; //do operation
-				if (validWord(word)) //check valid & write acc
-				{
-					*acPtr = word;
-					++(*icPtr);
-				}
-				else
-					throw std::runtime_error("invalid_input");
-				break;
-			case Command::multiply:
-				word = *acPtr * memory[*opPtr]; //do operation
-				if (validWord(word)) //check valid & write acc
-				{
-					*acPtr = word;
-					++(*icPtr);
-				}
-				else
-					throw std::runtime_error("invalid_input");
-				break;
-			case Command::divide:
-				if (memory[*opPtr] == 0) //div-by-zero check
-					throw std::runtime_error("invalid_input");
-				word = *acPtr / memory[*opPtr]; //do operation
-				if (validWord(word)) //check valid & write acc
-				{
-					*acPtr = word;
-					++(*icPtr);
-				}
-				else
-					throw std::runtime_error("invalid_input");
-				break;
-			case Command::branch:
-				*icPtr = *opPtr; //update instruction counter
-				break;
-			case Command::branchNeg:
-				*acPtr < 0 ? *icPtr = *opPtr : ++(*icPtr); //check negative, then branch
-				break;
-			case Command::branchZero:
-				*acPtr == 0 ? *icPtr = *opPtr : ++(*icPtr); //check zero, then branch
-				break;
-			case Command::halt:
-				//dump(memory, acPtr, *icPtr, *irPtr, *opCodePtr, *opPtr);
-				break;
-			default:
-				//any instruction necessary?
-				break;
-		}
+	//run instructions until halt
+	if (run(memory, acPtr, icPtr, irPtr, opCodePtr, opPtr, inputs, &inputIndex,
+		UINT64_MAX, &executed, observer) == Termination::faulted)
+		throw std::runtime_error("invalid_input");
+}
 
-	} while (opCodeToCommand(*opCodePtr) != Command::halt);
+namespace
+{
+	//register line as output() prints it, label padded to 22 then a tab
+	char* formatRegister(char* out, std::string_view label, int width, int value, bool sign)
+	{
+		std::memcpy(out, label.data(), label.size());
+		out += label.size();
+		for (size_t i = label.size(); i < 22; ++i)
+			*out++ = ' ';
+		*out++ = '\t';
+
+		if (sign)
+			out = format_word(out, value, width);
+		else
+			out = format_padded(out, static_cast<unsigned>(abs(value)), width);
+		*out++ = '\n';
+		return out;
+	}
 }
 
-void dump(std::array<int, memorySize>& memory, int* const acPtr,
+size_t format_dump(char* buffer, const std::array<int, memorySize>& memory, int accumulator,
 	size_t instructionCounter, size_t instructionRegister,
 	size_t operationCode, size_t operand)
 {
-	//print top-label
-	std::cout << "Memory:" << "\n";
-
-	//print column labels
-	std::cout << "    "; //pad
-	for (int col = 0; col < 10; col++)
-		std::cout << col << "    ";
-	std::cout << "\n";
+	char* out{ buffer };
 
+	//print top-label and column labels
+	out = format_literal(out, "Memory:\n    0    1    2    3    4    5    6    7    8    9    \n");
 
 	for (int row = 0; row < 10; ++row) {
-		//print row label
-		std::cout << std::setw(2) << row * 10 << " ";
+		//print row label, padded to two like setw(2)
+		if (row == 0)
+			out = format_literal(out, " 0 ");
+		else
+		{
+			*out++ = static_cast<char>('0' + row);
+			out = format_literal(out, "0 ");
+		}
 
 		// print memory in row
 		for (int col = 0; col < 10; ++col)
-		{
-			//check sign and print accordingly
-			int val = memory[row * 10 + col];
-			if (val < 0)
-				std::cout << "-" << std::setw(4) << std::setfill('0') << abs(memory[row * 10 + col]);
-			else
-				std::cout << "+" << std::setw(4) << std::setfill('0') << memory[row * 10 + col];
-		}
+			out = format_word(out, memory[row * 10 + col], 4);
+		*out++ = '\n';
+	}
 
-		std::cout << "\n";
+	//print register contents
+	out = format_literal(out, "\nRegisters\n");
+	out = formatRegister(out, "Accumulator", 4, accumulator, true);
+	out = formatRegister(out, "instructionCounter", 2, static_cast<int>(instructionCounter), false);
+	out = formatRegister(out, "instructionRegister", 4, static_cast<int>(instructionRegister), true);
+	out = formatRegister(out, "operationCode", 2, static_cast<int>(operationCode), false);
+	out = formatRegister(out, "operand", 2, static_cast<int>(operand), false);
+	*out++ = '\n';
+
+	return static_cast<size_t>(out - buffer);
+}
+
+void dump_to_fd(int fd, const std::array<int, memorySize>& memory, int accumulator,
+	size_t instructionCounter, size_t instructionRegister,
+	size_t operationCode, size_t operand)
+{
+	char buffer[dumpBufferSize];
+	const size_t size{ format_dump(buffer, memory, accumulator,
+		instructionCounter, instructionRegister, operationCode, operand) };
+
+	//one write for the whole report, retried only if it is cut short
+	for (size_t written = 0; written < size;)
+	{
+		const ssize_t count{ ::write(fd, buffer + written, size - written) };
+		if (count <= 0)
+			throw std::runtime_error("invalid_input");
+		written += static_cast<size_t>(count);
 	}
+}
 
-	//print register contents using output function
-	std::cout << '\n' << "Registers" << '\n';
-	output("Accumulator", 4, *acPtr, true);
-	output("instructionCounter", 2, instructionCounter, false);
-	output("instructionRegister", 4, instructionRegister, true);
-	output("operationCode", 2, operationCode, false);
-	output("operand", 2, operand, false);
-	std::cout << '\n';
+void dump(std::array<int, memorySize>& memory, int* const acPtr,
+	size_t instructionCounter, size_t instructionRegister,
+	size_t operationCode, size_t operand)
+{
+	//format the whole report first, then hand it to cout at once
+	char buffer[dumpBufferSize];
+	const size_t size{ format_dump(buffer, memory, *acPtr,
+		instructionCounter, instructionRegister, operationCode, operand) };
+	std::cout.write(buffer, static_cast<std::streamsize>(size));
 }
 
 bool validWord(int word)
@@ -214,7 +228,7 @@ bool validWord(int word)
 	return true;
 }
 
-void output(std::string label, int width, int value, bool sign)
+void output(const std::string& label, int width, int value, bool sign)
 {
 	//print the label with a constant width for formatting
 	std::cout << std::setw(22) << std::setfill(' ') << std::left << label << "\t";
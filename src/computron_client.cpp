@@ -0,0 +1,37 @@
+#include "computrond.h"
+
+#include <string>
+
+//usage: computron-client <socket path> <program id> [input]...
+int main(int argc, char* argv[]) {
+    if (argc < 3)
+    {
+        std::cerr << "usage: computron-client <socket> <program id> [input]...\n";
+        return 1;
+    }
+
+    std::vector<int> inputs;
+    for (int i = 3; i < argc; i++)
+        inputs.push_back(std::stoi(argv[i]));
+
+    DaemonClient client(argv[1]);
+    const RunResponse response = client.run(static_cast<uint32_t>(std::stoul(argv[2])), inputs);
+    if (response.status == RunStatus::badRequest)
+    {
+        std::cerr << "bad request\n";
+        return 1;
+    }
+
+    //print write output, then the usual dump
+    for (int output : response.outputs)
+        std::cout << output << '\n';
+
+    const MachineState& state = response.state;
+    std::array<int, memorySize> memory = state.memory;
+    int accumulator = state.accumulator;
+    dump(memory, &accumulator,
+        state.instructionCounter, state.instructionRegister,
+        state.operationCode, state.operand);
+
+    return response.status == RunStatus::halted ? 0 : 2;
+}
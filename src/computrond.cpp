@@ -0,0 +1,404 @@
+#include "computrond.h"
+
+#include <stdexcept>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+	//little-endian writers
+	void put8(std::string& out, uint8_t value)
+	{
+		out.push_back(static_cast<char>(value));
+	}
+
+	void put16(std::string& out, uint16_t value)
+	{
+		put8(out, value & 0xFF);
+		put8(out, value >> 8);
+	}
+
+	void put32(std::string& out, uint32_t value)
+	{
+		put16(out, value & 0xFFFF);
+		put16(out, value >> 16);
+	}
+
+	//bounds-checked little-endian reader over a frame
+	class Reader
+	{
+	public:
+		explicit Reader(std::string_view data) : data{ data } {}
+
+		uint8_t get8()
+		{
+			if (position >= data.size())
+				throw std::runtime_error("invalid_input");
+			return static_cast<uint8_t>(data[position++]);
+		}
+
+		uint16_t get16()
+		{
+			const uint16_t low{ get8() };
+			return static_cast<uint16_t>(low | get8() << 8);
+		}
+
+		uint32_t get32()
+		{
+			const uint32_t low{ get16() };
+			return low | static_cast<uint32_t>(get16()) << 16;
+		}
+
+		bool done() const { return position == data.size(); }
+
+	private:
+		std::string_view data;
+		size_t position{ 0 };
+	};
+
+	void putInputs(std::string& out, const std::vector<int>& inputs)
+	{
+		if (inputs.size() > UINT16_MAX)
+			throw std::runtime_error("invalid_input");
+
+		put16(out, static_cast<uint16_t>(inputs.size()));
+		for (int input : inputs)
+			put32(out, static_cast<uint32_t>(input));
+	}
+
+	std::vector<int> getInputs(Reader& reader)
+	{
+		//inputs outside the word range are refused before they reach a run
+		std::vector<int> inputs(reader.get16());
+		for (int& input : inputs)
+		{
+			input = static_cast<int32_t>(reader.get32());
+			if (!validWord(input))
+				throw std::runtime_error("invalid_input");
+		}
+		return inputs;
+	}
+
+	//full read or write on a blocking descriptor
+	bool readAll(int fd, char* data, size_t size)
+	{
+		while (size > 0)
+		{
+			const ssize_t count = ::read(fd, data, size);
+			if (count <= 0)
+				return false;
+			data += count;
+			size -= static_cast<size_t>(count);
+		}
+		return true;
+	}
+
+	bool writeAll(int fd, const char* data, size_t size)
+	{
+		while (size > 0)
+		{
+			//a vanished peer must not raise SIGPIPE in the daemon
+			const ssize_t count = ::send(fd, data, size, MSG_NOSIGNAL);
+			if (count <= 0)
+				return false;
+			data += count;
+			size -= static_cast<size_t>(count);
+		}
+		return true;
+	}
+
+	sockaddr_un socketAddress(const std::string& socketPath)
+	{
+		sockaddr_un address{};
+		address.sun_family = AF_UNIX;
+		if (socketPath.size() >= sizeof(address.sun_path))
+			throw std::runtime_error("invalid_input");
+		socketPath.copy(address.sun_path, socketPath.size());
+		return address;
+	}
+
+	constexpr size_t maxFrame{ 1 << 20 }; //rejects garbage length prefixes
+
+	//a response with every output it may carry still fits in a frame
+	static_assert(17 + 4 * memorySize + 2 + 4 * daemonOutputLimit <= maxFrame);
+
+	RunStatus statusOf(Termination termination)
+	{
+		switch (termination)
+		{
+			case Termination::halted: return RunStatus::halted;
+			case Termination::faulted: return RunStatus::faulted;
+			default: return RunStatus::budgetExceeded;
+		}
+	}
+}
+
+std::string encode_run_request(uint32_t programId, const std::vector<int>& inputs)
+{
+	std::string out;
+	put8(out, static_cast<uint8_t>(RequestKind::runProgram));
+	put32(out, programId);
+	putInputs(out, inputs);
+	return out;
+}
+
+std::string encode_image_request(const std::array<int, memorySize>& memory,
+	const std::vector<int>& inputs)
+{
+	std::string out;
+	put8(out, static_cast<uint8_t>(RequestKind::runImage));
+	put16(out, memorySize);
+	for (int word : memory)
+		put32(out, static_cast<uint32_t>(word));
+	putInputs(out, inputs);
+	return out;
+}
+
+std::string encode_response(const RunResponse& response)
+{
+	const MachineState& state = response.state;
+
+	std::string out;
+	out.reserve(17 + 4 * memorySize + 4 * response.outputs.size());
+	put8(out, static_cast<uint8_t>(response.status));
+	put32(out, static_cast<uint32_t>(state.accumulator));
+	put16(out, static_cast<uint16_t>(state.instructionCounter));
+	put32(out, static_cast<uint32_t>(state.instructionRegister));
+	put16(out, static_cast<uint16_t>(state.operationCode));
+	put16(out, static_cast<uint16_t>(state.operand));
+	for (int word : state.memory)
+		put32(out, static_cast<uint32_t>(word));
+
+	if (response.outputs.size() > UINT16_MAX)
+		throw std::runtime_error("invalid_input");
+
+	put16(out, static_cast<uint16_t>(response.outputs.size()));
+	for (int output : response.outputs)
+		put32(out, static_cast<uint32_t>(output));
+	return out;
+}
+
+RunResponse decode_response(std::string_view frame)
+{
+	Reader reader(frame);
+	RunResponse response;
+	MachineState& state = response.state;
+
+	response.status = static_cast<RunStatus>(reader.get8());
+	state.accumulator = static_cast<int32_t>(reader.get32());
+	state.instructionCounter = reader.get16();
+	state.instructionRegister = static_cast<int32_t>(reader.get32());
+	state.operationCode = reader.get16();
+	state.operand = reader.get16();
+	for (int& word : state.memory)
+		word = static_cast<int32_t>(reader.get32());
+
+	response.outputs.resize(reader.get16());
+	for (int& output : response.outputs)
+		output = static_cast<int32_t>(reader.get32());
+
+	if (!reader.done())
+		throw std::runtime_error("invalid_input");
+	return response;
+}
+
+RunResponse run_program(const std::array<int, memorySize>& memory,
+	const std::vector<int>& inputs, size_t budget, size_t outputLimit)
+{
+	RunResponse response;
+	MachineState& state = response.state;
+	state.memory = memory;
+
+	try
+	{
+		for (size_t i = 0; i < budget; ++i)
+		{
+			//collect the word a write instruction would print
+			switch (step(state, inputs))
+			{
+				case Command::write:
+					if (response.outputs.size() == outputLimit)
+					{
+						response.status = RunStatus::outputExceeded;
+						return response;
+					}
+					response.outputs.push_back(state.memory[state.operand]);
+					break;
+				case Command::halt:
+					response.status = RunStatus::halted;
+					return response;
+				default:
+					break;
+			}
+		}
+		response.status = RunStatus::budgetExceeded;
+	}
+	catch (const std::runtime_error&)
+	{
+		response.status = RunStatus::faulted;
+	}
+
+	return response;
+}
+
+std::vector<Precomputed> preload_programs(const std::vector<std::array<int, memorySize>>& images)
+{
+	std::vector<Precomputed> programs;
+	programs.reserve(images.size());
+	for (const std::array<int, memorySize>& image : images)
+		programs.push_back(precompute(image, daemonBudget));
+	return programs;
+}
+
+std::string handle_request(const std::vector<Precomputed>& programs,
+	std::string_view request)
+{
+	RunResponse bad;
+
+	try
+	{
+		Reader reader(request);
+		switch (static_cast<RequestKind>(reader.get8()))
+		{
+			case RequestKind::runProgram:
+			{
+				const uint32_t id{ reader.get32() };
+				const std::vector<int> inputs{ getInputs(reader) };
+				if (id >= programs.size() || !reader.done())
+					break;
+				RunResponse response;
+				uint64_t executed{ 0 };
+				response.status = statusOf(run_precomputed(programs[id], inputs, daemonBudget,
+					&response.state, &executed, &response.outputs));
+
+				//too much output, rerun from the image to stop at the limit
+				if (response.outputs.size() > daemonOutputLimit)
+					response = run_program(programs[id].image, inputs, daemonBudget, daemonOutputLimit);
+				return encode_response(response);
+			}
+			case RequestKind::runImage:
+			{
+				//short images are zero filled like a fresh memory
+				std::array<int, memorySize> memory{ 0 };
+				const size_t words{ reader.get16() };
+				if (words > memorySize)
+					break;
+				for (size_t i = 0; i < words; ++i)
+					memory[i] = static_cast<int32_t>(reader.get32());
+				const std::vector<int> inputs{ getInputs(reader) };
+				if (!reader.done())
+					break;
+				return encode_response(run_program(memory, inputs, daemonBudget, daemonOutputLimit));
+			}
+			default:
+				break;
+		}
+	}
+	catch (const std::runtime_error&)
+	{
+		//truncated request, answered as bad below
+	}
+
+	return encode_response(bad);
+}
+
+bool read_frame(int fd, std::string& frame)
+{
+	unsigned char prefix[4];
+	if (!readAll(fd, reinterpret_cast<char*>(prefix), sizeof(prefix)))
+		return false;
+
+	const uint32_t size{ prefix[0] | prefix[1] << 8 | prefix[2] << 16 | static_cast<uint32_t>(prefix[3]) << 24 };
+	if (size > maxFrame)
+		return false;
+
+	frame.resize(size);
+	return readAll(fd, frame.data(), size);
+}
+
+bool write_frame(int fd, std::string_view frame)
+{
+	//send prefix and payload with one write
+	std::string out;
+	out.reserve(4 + frame.size());
+	put32(out, static_cast<uint32_t>(frame.size()));
+	out.append(frame);
+	return writeAll(fd, out.data(), out.size());
+}
+
+void serve_connection(int fd, const std::vector<Precomputed>& programs)
+{
+	std::string frame;
+	while (read_frame(fd, frame))
+	{
+		if (!write_frame(fd, handle_request(programs, frame)))
+			break;
+	}
+}
+
+void serve(const std::string& socketPath, const std::vector<Precomputed>& programs)
+{
+	const sockaddr_un address{ socketAddress(socketPath) };
+
+	//replace a stale socket from an earlier run
+	const int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	::unlink(socketPath.c_str());
+	if (listener < 0
+		|| ::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+		|| ::listen(listener, SOMAXCONN) != 0)
+		throw std::runtime_error("invalid_input");
+
+	while (true)
+	{
+		const int client = ::accept(listener, nullptr, nullptr);
+		if (client < 0)
+			continue;
+
+		//programs outlive every connection, they are never modified
+		std::thread([client, &programs]
+		{
+			serve_connection(client, programs);
+			::close(client);
+		}).detach();
+	}
+}
+
+DaemonClient::DaemonClient(const std::string& socketPath)
+{
+	const sockaddr_un address{ socketAddress(socketPath) };
+
+	fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0 || ::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+	{
+		if (fd >= 0)
+			::close(fd);
+		throw std::runtime_error("invalid_input");
+	}
+}
+
+DaemonClient::~DaemonClient()
+{
+	::close(fd);
+}
+
+RunResponse DaemonClient::run(uint32_t programId, const std::vector<int>& inputs)
+{
+	return roundTrip(encode_run_request(programId, inputs));
+}
+
+RunResponse DaemonClient::run(const std::array<int, memorySize>& memory, const std::vector<int>& inputs)
+{
+	return roundTrip(encode_image_request(memory, inputs));
+}
+
+RunResponse DaemonClient::roundTrip(const std::string& request)
+{
+	std::string frame;
+	if (!write_frame(fd, request) || !read_frame(fd, frame))
+		throw std::runtime_error("invalid_input");
+
+	return decode_response(frame);
+}
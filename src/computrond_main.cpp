@@ -0,0 +1,21 @@
+#include "computrond.h"
+
+//usage: computrond <socket path> <program file>...
+//program ids are the positions of the files on the command line
+int main(int argc, char* argv[]) {
+    if (argc < 3)
+    {
+        std::cerr << "usage: computrond <socket> <program>...\n";
+        return 1;
+    }
+
+    //load and precompute every program once up front
+    std::vector<std::array<int, memorySize>> images(argc - 2);
+    for (int i = 2; i < argc; i++)
+    {
+        images[i - 2].fill(0);
+        load_from_file(images[i - 2], argv[i]);
+    }
+
+    serve(argv[1], preload_programs(images));
+}
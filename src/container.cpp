@@ -0,0 +1,232 @@
+#include "container.h"
+
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//images are mapped straight into int32_t words
+static_assert(std::endian::native == std::endian::little);
+
+namespace
+{
+	constexpr char magic[8]{ 'C', 'T', 'R', 'N', 'P', 'A', 'K', '1' };
+	constexpr uint32_t version{ 1 };
+	constexpr size_t headerSize{ 40 };
+	constexpr size_t entrySize{ 24 };
+	constexpr size_t imageSize{ memorySize * sizeof(int32_t) };
+
+	constexpr uint64_t fnvOffset{ 14695981039346656037ULL };
+	constexpr uint64_t fnvPrime{ 1099511628211ULL };
+
+	uint64_t hashBytes(const void* bytes, size_t size, uint64_t hash = fnvOffset)
+	{
+		const unsigned char* p{ static_cast<const unsigned char*>(bytes) };
+		for (size_t i = 0; i < size; ++i)
+			hash = (hash ^ p[i]) * fnvPrime;
+		return hash;
+	}
+
+	template <typename T>
+	void put(std::string& out, T value)
+	{
+		out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+	}
+
+	template <typename T>
+	T get(const unsigned char* at)
+	{
+		T value;
+		std::memcpy(&value, at, sizeof(value));
+		return value;
+	}
+
+	//smallest power of two with room for twice the entries
+	size_t slotCount(size_t entries)
+	{
+		size_t slots{ 1 };
+		while (slots < entries * 2)
+			slots <<= 1;
+		return slots;
+	}
+}
+
+uint64_t program_hash(const std::array<int, memorySize>& memory)
+{
+	uint64_t hash{ fnvOffset };
+	for (int word : memory)
+	{
+		const int32_t value{ word };
+		hash = hashBytes(&value, sizeof(value), hash);
+	}
+	return hash;
+}
+
+void write_container(const std::string& path, const ProgramBatch& batch)
+{
+	const size_t count{ batch.index.size() };
+	const size_t slots{ slotCount(count) };
+	const size_t indexOffset{ headerSize + count * imageSize };
+	const size_t namesOffset{ indexOffset + count * entrySize };
+
+	//images, index and names are built in order in one buffer
+	std::string names;
+	std::string out;
+	out.reserve(namesOffset);
+	out.append(magic, sizeof(magic));
+	put<uint32_t>(out, version);
+	put<uint32_t>(out, static_cast<uint32_t>(count));
+	put<uint64_t>(out, namesOffset);
+	put<uint64_t>(out, 0); //hash table offset, patched below
+	put<uint32_t>(out, static_cast<uint32_t>(slots));
+	put<uint32_t>(out, 0);
+
+	std::array<int, memorySize> memory;
+	for (size_t i = 0; i < count; ++i)
+	{
+		batch.image(i, memory);
+		for (int word : memory)
+			put<int32_t>(out, word);
+	}
+
+	std::vector<uint32_t> hashTable(slots, 0);
+	for (size_t i = 0; i < count; ++i)
+	{
+		const BatchEntry& entry = batch.index[i];
+		batch.image(i, memory);
+		put<uint64_t>(out, namesOffset + names.size());
+		put<uint32_t>(out, static_cast<uint32_t>(entry.name.size()));
+		put<uint32_t>(out, static_cast<uint32_t>(entry.wordCount));
+		put<uint64_t>(out, program_hash(memory));
+		names += entry.name;
+
+		//first free slot after the name's home slot
+		size_t slot{ hashBytes(entry.name.data(), entry.name.size()) & (slots - 1) };
+		while (hashTable[slot] != 0)
+			slot = (slot + 1) & (slots - 1);
+		hashTable[slot] = static_cast<uint32_t>(i + 1);
+	}
+
+	//names, then the hash table on a four byte boundary
+	out += names;
+	out.append((4 - out.size() % 4) % 4, '\0');
+	const uint64_t hashOffset{ out.size() };
+	std::memcpy(&out[24], &hashOffset, sizeof(hashOffset));
+	out.append(reinterpret_cast<const char*>(hashTable.data()), slots * sizeof(uint32_t));
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file.write(out.data(), static_cast<std::streamsize>(out.size())))
+		throw std::runtime_error("invalid_input");
+}
+
+ProgramContainer::ProgramContainer(const std::string& path)
+{
+	//map the whole file read-only
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	struct stat info{};
+	if (fd < 0 || ::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < headerSize)
+	{
+		if (fd >= 0)
+			::close(fd);
+		throw std::runtime_error("invalid_input");
+	}
+
+	length = static_cast<size_t>(info.st_size);
+	void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (mapping == MAP_FAILED)
+		throw std::runtime_error("invalid_input");
+	data = static_cast<const unsigned char*>(mapping);
+
+	//check the header and that every table lies inside the file
+	count = get<uint32_t>(data + 12);
+	const uint64_t namesOffset{ get<uint64_t>(data + 16) };
+	const uint64_t hashOffset{ get<uint64_t>(data + 24) };
+	hashSlots = get<uint32_t>(data + 32);
+	const size_t indexOffset{ headerSize + count * imageSize };
+
+	if (std::memcmp(data, magic, sizeof(magic)) != 0 || get<uint32_t>(data + 8) != version
+		|| namesOffset != indexOffset + count * entrySize || hashOffset < namesOffset
+		|| hashOffset % 4 != 0 || hashSlots == 0 || (hashSlots & (hashSlots - 1)) != 0
+		|| hashOffset > length || hashSlots * sizeof(uint32_t) > length - hashOffset)
+	{
+		::munmap(const_cast<unsigned char*>(data), length);
+		throw std::runtime_error("invalid_input");
+	}
+
+	index = data + indexOffset;
+	hashTable = reinterpret_cast<const uint32_t*>(data + hashOffset);
+	for (size_t i = 0; i < count; ++i)
+	{
+		const unsigned char* entry{ index + i * entrySize };
+		//compared without adding, so a corrupt offset cannot wrap around
+		const uint64_t offset{ get<uint64_t>(entry) };
+		if (offset > hashOffset || get<uint32_t>(entry + 8) > hashOffset - offset)
+		{
+			::munmap(const_cast<unsigned char*>(data), length);
+			throw std::runtime_error("invalid_input");
+		}
+	}
+}
+
+ProgramContainer::~ProgramContainer()
+{
+	::munmap(const_cast<unsigned char*>(data), length);
+}
+
+std::string_view ProgramContainer::name(size_t i) const
+{
+	if (i >= count)
+		throw std::runtime_error("invalid_input");
+
+	const unsigned char* entry{ index + i * entrySize };
+	return { reinterpret_cast<const char*>(data + get<uint64_t>(entry)), get<uint32_t>(entry + 8) };
+}
+
+size_t ProgramContainer::wordCount(size_t i) const
+{
+	if (i >= count)
+		throw std::runtime_error("invalid_input");
+	return get<uint32_t>(index + i * entrySize + 12);
+}
+
+uint64_t ProgramContainer::hash(size_t i) const
+{
+	if (i >= count)
+		throw std::runtime_error("invalid_input");
+	return get<uint64_t>(index + i * entrySize + 16);
+}
+
+const int32_t* ProgramContainer::words(size_t i) const
+{
+	if (i >= count)
+		throw std::runtime_error("invalid_input");
+	return reinterpret_cast<const int32_t*>(data + headerSize + i * imageSize);
+}
+
+void ProgramContainer::image(size_t i, std::array<int, memorySize>& memory) const
+{
+	const int32_t* source{ words(i) };
+	std::copy(source, source + memorySize, memory.begin());
+}
+
+size_t ProgramContainer::find(std::string_view name) const
+{
+	//probe from the home slot until an empty slot
+	size_t slot{ hashBytes(name.data(), name.size()) & (hashSlots - 1) };
+	for (size_t probes = 0; probes < hashSlots; ++probes)
+	{
+		const uint32_t entry{ hashTable[slot] };
+		if (entry == 0)
+			break;
+		if (entry <= count && this->name(entry - 1) == name)
+			return entry - 1;
+		slot = (slot + 1) & (hashSlots - 1);
+	}
+	return count;
+}
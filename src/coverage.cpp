@@ -0,0 +1,115 @@
+#include "coverage.h"
+#include "cfg.h"
+#include "isa.h"
+
+#include <stdexcept>
+
+namespace
+{
+	//packs a bitset into 64 bit words, lowest address first
+	void toWords(const std::bitset<memorySize>& bits, uint64_t* words)
+	{
+		for (size_t i = 0; i < memorySize; ++i)
+			if (bits[i])
+				words[i / 64] |= uint64_t{ 1 } << (i % 64);
+	}
+
+	std::bitset<memorySize> fromWords(const std::atomic<uint64_t>* words)
+	{
+		std::bitset<memorySize> bits;
+		for (size_t i = 0; i < memorySize; ++i)
+			if (words[i / 64].load(std::memory_order_relaxed) >> (i % 64) & 1)
+				bits.set(i);
+		return bits;
+	}
+
+	bool conditional(int word)
+	{
+		return (word_info(word).flags & flagConditional) != 0;
+	}
+}
+
+BatchCoverage::BatchCoverage(size_t programs)
+	: programs{ programs }, bits{ std::make_unique<std::atomic<uint64_t>[]>(programs * wordsPerProgram) }
+{
+	for (size_t i = 0; i < programs * wordsPerProgram; ++i)
+		bits[i].store(0, std::memory_order_relaxed);
+}
+
+void BatchCoverage::merge(size_t program, const CoverageMap& map)
+{
+	if (program >= programs)
+		throw std::runtime_error("invalid_input");
+
+	uint64_t words[wordsPerProgram]{};
+	toWords(map.executed, words);
+	toWords(map.taken, words + wordsPerMap);
+	toWords(map.notTaken, words + 2 * wordsPerMap);
+
+	//skip words with nothing to add, most jobs only touch a few
+	std::atomic<uint64_t>* target{ &bits[program * wordsPerProgram] };
+	for (size_t i = 0; i < wordsPerProgram; ++i)
+		if (words[i] != 0 && (target[i].load(std::memory_order_relaxed) & words[i]) != words[i])
+			target[i].fetch_or(words[i], std::memory_order_relaxed);
+}
+
+CoverageMap BatchCoverage::get(size_t program) const
+{
+	if (program >= programs)
+		throw std::runtime_error("invalid_input");
+
+	const std::atomic<uint64_t>* source{ &bits[program * wordsPerProgram] };
+	return { fromWords(source), fromWords(source + wordsPerMap), fromWords(source + 2 * wordsPerMap) };
+}
+
+CoverageReport report_coverage(const std::array<int, memorySize>& image, const CoverageMap& map)
+{
+	const ControlFlowGraph cfg{ build_cfg(image) };
+	CoverageReport report;
+
+	for (size_t address = 0; address < memorySize; ++address)
+	{
+		if (cfg.blockOf[address] == noBlock)
+			continue;
+
+		++report.instructions;
+		if (map.executed[address])
+			++report.covered;
+		else
+			report.uncovered.push_back(address);
+
+		//both directions of a conditional branch count separately
+		if (conditional(image[address]))
+		{
+			report.directions += 2;
+			report.directionsCovered += map.taken[address] + map.notTaken[address];
+			if (!map.taken[address])
+				report.neverTaken.push_back(address);
+			if (!map.notTaken[address])
+				report.alwaysTaken.push_back(address);
+		}
+	}
+
+	return report;
+}
+
+std::string format_coverage(const CoverageReport& report)
+{
+	std::string text{ "instructions " + std::to_string(report.covered) + "/" + std::to_string(report.instructions)
+		+ ", branch directions " + std::to_string(report.directionsCovered) + "/" + std::to_string(report.directions) + "\n" };
+
+	auto list = [&](const char* label, const std::vector<size_t>& addresses)
+	{
+		if (addresses.empty())
+			return;
+		text += label;
+		for (size_t address : addresses)
+			text += (address < 10 ? " 0" : " ") + std::to_string(address);
+		text += "\n";
+	};
+	list("uncovered:", report.uncovered);
+	list("never taken:", report.neverTaken);
+	list("never falls through:", report.alwaysTaken);
+
+	return text;
+}
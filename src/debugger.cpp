@@ -0,0 +1,306 @@
+#include "debugger.h"
+#include "isa.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+	constexpr uint8_t noWrite{ 0xFF };
+
+	//memory cell the instruction word would write, or noWrite
+	uint8_t writeTarget(int word)
+	{
+		if (word_info(word).flags & flagWritesMemory)
+			return static_cast<uint8_t>(word % 100);
+		return noWrite;
+	}
+
+	const char* reasonName(StopReason reason)
+	{
+		switch (reason)
+		{
+			case StopReason::stepped: return "stepped";
+			case StopReason::breakpoint: return "breakpoint";
+			case StopReason::watchpoint: return "watchpoint";
+			case StopReason::halted: return "halted";
+			case StopReason::faulted: return "faulted";
+			case StopReason::budgetExceeded: return "budget exceeded";
+			default: return "start";
+		}
+	}
+}
+
+Debugger::Debugger(const std::array<int, memorySize>& image, std::vector<int> inputs,
+	uint64_t checkpointInterval)
+	: inputs{ std::move(inputs) }, interval{ std::max<uint64_t>(checkpointInterval, 1) }
+{
+	current.memory = image;
+}
+
+void Debugger::add_breakpoint(size_t address)
+{
+	if (address >= memorySize)
+		throw std::runtime_error("invalid_input");
+	addressBreaks.set(address);
+	anyStops = true;
+}
+
+void Debugger::add_opcode_breakpoint(size_t opCode)
+{
+	if (opCode >= memorySize)
+		throw std::runtime_error("invalid_input");
+	opCodeBreaks[opCode] = true;
+	anyStops = true;
+}
+
+void Debugger::add_watchpoint(size_t address)
+{
+	if (address >= memorySize)
+		throw std::runtime_error("invalid_input");
+	watches.set(address);
+	anyStops = true;
+}
+
+void Debugger::clear_breakpoints()
+{
+	addressBreaks.reset();
+	watches.reset();
+	opCodeBreaks.fill(false);
+	anyStops = false;
+}
+
+StopReason Debugger::step()
+{
+	return forward();
+}
+
+StopReason Debugger::continue_run(uint64_t budget)
+{
+	//without stops there is nothing to check between steps
+	if (!anyStops)
+	{
+		for (uint64_t i = 0; i < budget; ++i)
+			if (const StopReason reason{ forward() }; reason != StopReason::stepped)
+				return reason;
+		return StopReason::budgetExceeded;
+	}
+
+	for (uint64_t i = 0; i < budget; ++i)
+	{
+		//a breakpoint at the starting address does not stop again
+		if (i != 0 && !ended && breaksAt(current.instructionCounter))
+			return StopReason::breakpoint;
+
+		if (const StopReason reason{ forward() }; reason != StopReason::stepped)
+			return reason;
+
+		const uint8_t written{ undoLog.back().writeAddress };
+		if (written != noWrite && watches[written])
+			return StopReason::watchpoint;
+	}
+	return StopReason::budgetExceeded;
+}
+
+StopReason Debugger::reverse_step()
+{
+	//a faulted instruction never completed, undoing it keeps the count
+	const bool undoFault{ faultLogged };
+	if (count == 0 && !undoFault)
+		return StopReason::start;
+
+	//steps before the last checkpoint have to be rebuilt first
+	if (undoLog.empty())
+	{
+		restoreBefore(count - 1);
+		return StopReason::stepped;
+	}
+
+	const UndoEntry& entry = undoLog.back();
+	current.accumulator = entry.accumulator;
+	current.instructionCounter = entry.instructionCounter;
+	current.instructionRegister = entry.instructionRegister;
+	current.operationCode = entry.operationCode;
+	current.operand = entry.operand;
+	current.inputIndex = entry.inputIndex;
+	if (entry.writeAddress != noWrite)
+		current.memory[entry.writeAddress] = entry.oldValue;
+	undoLog.pop_back();
+
+	if (!undoFault)
+		--count;
+	ended = false;
+	faultLogged = false;
+	return StopReason::stepped;
+}
+
+StopReason Debugger::reverse_continue()
+{
+	do
+	{
+		if (reverse_step() == StopReason::start)
+			return StopReason::start;
+
+		//the instruction just undone is the next one to execute
+		const size_t address{ current.instructionCounter };
+		if (breaksAt(address))
+			return StopReason::breakpoint;
+		const uint8_t written{ writeTarget(current.memory[address]) };
+		if (written != noWrite && watches[written])
+			return StopReason::watchpoint;
+	} while (count != 0);
+
+	return StopReason::start;
+}
+
+StopReason Debugger::forward()
+{
+	if (ended)
+		return endReason;
+
+	//a new window begins at every multiple of the interval
+	if (count % interval == 0 && (checkpoints.empty() || checkpoints.back().executed < count))
+	{
+		//at the limit keep every other checkpoint and take them half as often
+		if (checkpoints.size() == checkpointLimit)
+		{
+			interval *= 2;
+			std::erase_if(checkpoints, [this](const Snapshot& snapshot) { return snapshot.executed % interval != 0; });
+		}
+
+		//the undo log stays valid when this step is no longer a checkpoint
+		if (count % interval == 0)
+		{
+			checkpoints.push_back({ count, current });
+			undoLog.clear();
+		}
+	}
+
+	//running past the last word is a fault like any other
+	if (current.instructionCounter >= memorySize)
+	{
+		ended = true;
+		endReason = StopReason::faulted;
+		return endReason;
+	}
+
+	const uint8_t written{ writeTarget(current.memory[current.instructionCounter]) };
+	undoLog.push_back({ current.accumulator, static_cast<uint8_t>(current.instructionCounter),
+		current.instructionRegister, current.operationCode, current.operand, current.inputIndex,
+		written, written != noWrite ? current.memory[written] : 0 });
+
+	//count the step only once it completed
+	try
+	{
+		const Command command{ ::step(current, inputs) };
+		++count;
+		if (command != Command::halt)
+			return StopReason::stepped;
+		endReason = StopReason::halted;
+	}
+	catch (const std::runtime_error&)
+	{
+		endReason = StopReason::faulted;
+		faultLogged = true;
+	}
+
+	ended = true;
+	return endReason;
+}
+
+void Debugger::restoreBefore(uint64_t target)
+{
+	//drop checkpoints past the target and resume from the latest one left
+	while (checkpoints.back().executed > target)
+		checkpoints.pop_back();
+
+	const Snapshot& snapshot = checkpoints.back();
+	current = snapshot.state;
+	count = snapshot.executed;
+	ended = false;
+	faultLogged = false;
+	undoLog.clear();
+
+	//replaying rebuilds the undo log for the window
+	while (count < target)
+		forward();
+}
+
+bool Debugger::breaksAt(size_t address) const
+{
+	if (address >= memorySize)
+		return false;
+
+	const int word{ current.memory[address] };
+	return addressBreaks[address] || (word >= 0 && opCodeBreaks[static_cast<size_t>(word / 100)]);
+}
+
+void run_debugger(Debugger& debugger, std::istream& in, std::ostream& out)
+{
+	std::string line;
+	while (out << "(ctdb) " << std::flush, std::getline(in, line))
+	{
+		std::istringstream words(line);
+		std::string command;
+		size_t argument{ 0 };
+		words >> command >> argument;
+
+		StopReason reason;
+		if (command == "s")
+			reason = debugger.step();
+		else if (command == "c")
+			reason = debugger.continue_run();
+		else if (command == "rs")
+			reason = debugger.reverse_step();
+		else if (command == "rc")
+			reason = debugger.reverse_continue();
+		else if (command == "b" || command == "bo" || command == "w")
+		{
+			try
+			{
+				if (command == "b")
+					debugger.add_breakpoint(argument);
+				else if (command == "bo")
+					debugger.add_opcode_breakpoint(argument);
+				else
+					debugger.add_watchpoint(argument);
+			}
+			catch (const std::runtime_error&)
+			{
+				out << "invalid address\n";
+			}
+			continue;
+		}
+		else if (command == "d")
+		{
+			debugger.clear_breakpoints();
+			continue;
+		}
+		else if (command == "p")
+		{
+			const MachineState& state = debugger.state();
+			char buffer[dumpBufferSize];
+			out.write(buffer, static_cast<std::streamsize>(format_dump(buffer, state.memory, state.accumulator,
+				state.instructionCounter, state.instructionRegister, state.operationCode, state.operand)));
+			continue;
+		}
+		else if (command == "r")
+		{
+			const MachineState& state = debugger.state();
+			out << "ac " << state.accumulator << " ic " << state.instructionCounter
+				<< " ir " << state.instructionRegister << " executed " << debugger.executed() << '\n';
+			continue;
+		}
+		else if (command == "q")
+			break;
+		else
+		{
+			out << "commands: s c rs rc b <addr> bo <opcode> w <addr> d r p q\n";
+			continue;
+		}
+
+		out << reasonName(reason) << " at " << debugger.state().instructionCounter
+			<< " after " << debugger.executed() << " instructions\n";
+	}
+}
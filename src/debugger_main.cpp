@@ -0,0 +1,22 @@
+#include "debugger.h"
+
+#include <string>
+
+//usage: computron-dbg <program file> [input]...
+int main(int argc, char* argv[]) {
+    if (argc < 2)
+    {
+        std::cerr << "usage: computron-dbg <program> [input]...\n";
+        return 1;
+    }
+
+    std::array<int, memorySize> memory{ 0 };
+    load_from_file(memory, argv[1]);
+
+    std::vector<int> inputs;
+    for (int i = 2; i < argc; i++)
+        inputs.push_back(std::stoi(argv[i]));
+
+    Debugger debugger(memory, inputs);
+    run_debugger(debugger, std::cin, std::cout);
+}
@@ -0,0 +1,38 @@
+#include "batch_loader.h"
+#include "differential.h"
+
+#include <iostream>
+#include <string>
+
+//usage: computron-diff <program, directory or glob> [input]...
+int main(int argc, char* argv[]) {
+    if (argc < 2)
+    {
+        std::cerr << "usage: computron-diff <programs> [input]...\n";
+        return 1;
+    }
+
+    const ProgramBatch batch = load_batch(argv[1]);
+    for (const BatchError& error : batch.errors)
+        std::cerr << error.name << ": " << error.message << '\n';
+
+    std::vector<int> inputs;
+    for (int i = 2; i < argc; i++)
+        inputs.push_back(std::stoi(argv[i]));
+
+    //every engine against the reference, one line per divergence
+    size_t diverged{ 0 };
+    std::array<int, memorySize> memory{ 0 };
+    for (size_t i = 0; i < batch.index.size(); i++)
+    {
+        batch.image(i, memory);
+        for (const Divergence& divergence : compare_engines(memory, inputs, alternative_engines()))
+        {
+            std::cout << batch.index[i].name << ": " << format_divergence(divergence) << '\n';
+            ++diverged;
+        }
+    }
+
+    std::cout << batch.index.size() << " programs, " << diverged << " divergences\n";
+    return diverged == 0 && batch.errors.empty() ? 0 : 2;
+}
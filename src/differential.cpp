@@ -0,0 +1,286 @@
+#include "differential.h"
+#include "computrond.h"
+#include "debugger.h"
+#include "expression_dag.h"
+#include "interpreter.h"
+#include "isa.h"
+#include "loop_summary.h"
+#include "precompute.h"
+#include "replay.h"
+#include "scheduler.h"
+#include "ssa.h"
+#include "state_record.h"
+#include "tiered.h"
+#include "verifier.h"
+
+#include <stdexcept>
+
+namespace
+{
+	EngineRun runInterpreter(const std::array<int, memorySize>& image, const std::vector<int>& inputs, uint64_t budget)
+	{
+		EngineRun result;
+		result.state.memory = image;
+		OutputObserver observer(&result.outputs);
+		result.termination = run(result.state, inputs, budget, &result.executed, observer);
+		return result;
+	}
+
+	EngineRun runUnchecked(const std::array<int, memorySize>& image, const std::vector<int>& inputs, uint64_t budget)
+	{
+		EngineRun result;
+		result.state.memory = image;
+		result.recordsOutputs = false;
+		result.termination = run_unchecked(result.state, inputs, budget, &result.executed, verify_program(image));
+		return result;
+	}
+
+	EngineRun runSsa(const std::array<int, memorySize>& image, const std::vector<int>& inputs, uint64_t budget)
+	{
+		IrProgram program{ lift_to_ssa(image) };
+		optimize_ssa(program);
+
+		EngineRun result;
+		result.termination = run_ssa(program, inputs, budget, &result.state, &result.executed, &result.outputs);
+		return result;
+	}
+
+	EngineRun runSummarized(const std::array<int, memorySize>& image, const std::vector<int>& inputs, uint64_t budget)
+	{
+		EngineRun result;
+		result.state.memory = image;
+		result.termination = run_summarized(result.state, inputs, budget, &result.executed,
+			summarize_loops(image), &result.outputs);
+		return result;
+	}
+
+	EngineRun runPrecomputed(const std::array<int, memorySize>& image, const std::vector<int>& inputs, uint64_t budget)
+	{
+		return run_precomputed_engine(precompute(image, budget), inputs, budget);
+	}
+
+	EngineRun runDag(const std::array<int, memorySize>& image, const std::vector<int>& inputs, uint64_t budget)
+	{
+		const ExpressionDag dag{ build_dag(image) };
+		const DagBatchResult batch{ run_dag_batch(dag, { inputs }, budget) };
+
+		EngineRun result;
+		result.termination = batch_row(dag, batch, 0, &result.state, &result.executed, &result.outputs);
+		return result;
+	}
+
+	EngineRun runTiered(const std::array<int, memorySize>& image, const std::vector<int>& inputs, uint64_t budget)
+	{
+		//a fresh engine per comparison with low thresholds, so programs
+		//change tier and record traces in the middle of runs. the first run
+		//warms the profile and the second starts in the tier it earned.
+		TieredEngine engine({ 16, 256, 16 });
+		run_tiered_engine(engine, image, inputs, budget);
+		return run_tiered_engine(engine, image, inputs, budget);
+	}
+
+	Termination terminationOf(RunStatus status)
+	{
+		switch (status)
+		{
+			case RunStatus::halted: return Termination::halted;
+			case RunStatus::budgetExceeded: return Termination::budgetExceeded;
+			default: return Termination::faulted; //without an output limit run_program only faults otherwise
+		}
+	}
+
+	EngineRun runDaemon(const std::array<int, memorySize>& image, const std::vector<int>& inputs, uint64_t budget)
+	{
+		RunResponse response{ run_program(image, inputs, budget) };
+
+		EngineRun result;
+		result.termination = terminationOf(response.status);
+		result.state = response.state;
+		result.outputs = std::move(response.outputs);
+		result.countsExecuted = false;
+		return result;
+	}
+
+	EngineRun runScheduler(const std::array<int, memorySize>& image, const std::vector<int>& inputs, uint64_t budget)
+	{
+		//a small quantum makes every run cross several slices
+		Scheduler scheduler(1, 7);
+		const size_t id{ scheduler.submit(image, inputs, 1, budget) };
+		scheduler.wait();
+		const JobResult& job = scheduler.result(id);
+
+		EngineRun result;
+		result.state = job.state;
+		result.executed = job.executed;
+		result.recordsOutputs = false;
+		switch (job.status)
+		{
+			case JobStatus::faulted:
+				result.termination = Termination::faulted;
+				break;
+			case JobStatus::budgetExceeded:
+				result.termination = Termination::budgetExceeded;
+				break;
+			default:
+				result.termination = Termination::halted;
+		}
+		return result;
+	}
+
+	EngineRun runDebugger(const std::array<int, memorySize>& image, const std::vector<int>& inputs, uint64_t budget)
+	{
+		//a short interval keeps the checkpoint and undo paths busy
+		Debugger debugger(image, inputs, 16);
+		const StopReason reason{ debugger.continue_run(budget) };
+
+		EngineRun result;
+		result.state = debugger.state();
+		result.executed = debugger.executed();
+		result.recordsOutputs = false;
+		switch (reason)
+		{
+			case StopReason::faulted:
+				result.termination = Termination::faulted;
+				break;
+			case StopReason::budgetExceeded:
+				result.termination = Termination::budgetExceeded;
+				break;
+			default:
+				result.termination = Termination::halted;
+		}
+		return result;
+	}
+
+	const char* registerDifference(const MachineState& a, const MachineState& b)
+	{
+		if (a.accumulator != b.accumulator)
+			return "accumulator";
+		if (a.instructionCounter != b.instructionCounter)
+			return "instructionCounter";
+		if (a.instructionRegister != b.instructionRegister)
+			return "instructionRegister";
+		if (a.operationCode != b.operationCode)
+			return "operationCode";
+		if (a.operand != b.operand)
+			return "operand";
+		if (a.inputIndex != b.inputIndex)
+			return "inputIndex";
+		return nullptr;
+	}
+}
+
+EngineRun run_reference(const std::array<int, memorySize>& image, const std::vector<int>& inputs, uint64_t budget)
+{
+	RunLog log{ record_run(image, inputs, 0, budget) };
+
+	EngineRun result;
+	result.termination = log.termination;
+	result.state = log.final;
+	result.executed = log.executed;
+	result.outputs = std::move(log.outputs);
+	return result;
+}
+
+const std::vector<Engine>& alternative_engines()
+{
+	static const std::vector<Engine> engines{
+		{ "interpreter", runInterpreter },
+		{ "unchecked", runUnchecked },
+		{ "ssa", runSsa },
+		{ "summarized", runSummarized },
+		{ "precomputed", runPrecomputed },
+		{ "dag", runDag },
+		{ "tiered", runTiered },
+		{ "daemon", runDaemon },
+		{ "scheduler", runScheduler },
+		{ "debugger", runDebugger },
+	};
+	return engines;
+}
+
+const Engine& find_engine(std::string_view name)
+{
+	for (const Engine& engine : alternative_engines())
+		if (name == engine.name)
+			return engine;
+	throw std::runtime_error("invalid_input");
+}
+
+EngineRun run_precomputed_engine(const Precomputed& precomputed, const std::vector<int>& inputs, uint64_t budget)
+{
+	EngineRun result;
+	result.termination = run_precomputed(precomputed, inputs, budget,
+		&result.state, &result.executed, &result.outputs);
+	return result;
+}
+
+EngineRun run_tiered_engine(TieredEngine& engine, const std::array<int, memorySize>& image,
+	const std::vector<int>& inputs, uint64_t budget)
+{
+	EngineRun result;
+	result.termination = engine.run(image, inputs, budget, &result.state, &result.executed, &result.outputs);
+	return result;
+}
+
+std::string first_difference(const EngineRun& expected, const EngineRun& actual)
+{
+	if (expected.termination != actual.termination)
+		return "termination";
+	if (expected.countsExecuted && actual.countsExecuted && expected.executed != actual.executed)
+		return "executed";
+	if (const char* name{ registerDifference(expected.state, actual.state) })
+		return name;
+
+	for (size_t i = 0; i < memorySize; ++i)
+		if (expected.state.memory[i] != actual.state.memory[i])
+			return "memory[" + std::to_string(i) + "]";
+
+	if (expected.recordsOutputs && actual.recordsOutputs && expected.outputs != actual.outputs)
+		return "outputs";
+	return "";
+}
+
+std::vector<Divergence> compare_engines(const std::array<int, memorySize>& image,
+	const std::vector<int>& inputs, const std::vector<Engine>& engines, uint64_t budget)
+{
+	std::vector<Divergence> divergences;
+	const EngineRun reference{ run_reference(image, inputs, budget) };
+
+	for (const Engine& engine : engines)
+	{
+		if (first_difference(reference, engine.run(image, inputs, budget)).empty())
+			continue;
+
+		//both agree before any instruction runs, so search (0, budget] for
+		//the smallest budget after which they disagree
+		uint64_t agree{ 0 };
+		uint64_t differ{ budget };
+		while (differ - agree > 1)
+		{
+			const uint64_t middle{ agree + (differ - agree) / 2 };
+			if (first_difference(run_reference(image, inputs, middle), engine.run(image, inputs, middle)).empty())
+				agree = middle;
+			else
+				differ = middle;
+		}
+
+		Divergence divergence;
+		divergence.engine = engine.name;
+		divergence.instruction = differ - 1;
+		divergence.address = run_reference(image, inputs, differ - 1).state.instructionCounter;
+		divergence.expected = run_reference(image, inputs, differ);
+		divergence.actual = engine.run(image, inputs, differ);
+		divergence.field = first_difference(divergence.expected, divergence.actual);
+		divergences.push_back(std::move(divergence));
+	}
+
+	return divergences;
+}
+
+std::string format_divergence(const Divergence& divergence)
+{
+	return divergence.engine + ": instruction " + std::to_string(divergence.instruction)
+		+ " at address " + std::to_string(divergence.address) + ", " + divergence.field
+		+ " differs (reference " + termination_name(divergence.expected.termination)
+		+ ", engine " + termination_name(divergence.actual.termination) + ")";
+}
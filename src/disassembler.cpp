@@ -0,0 +1,141 @@
+#include "disassembler.h"
+#include "cfg.h"
+#include "format.h"
+#include "isa.h"
+
+namespace
+{
+	//mnemonic column width, the longest mnemonic plus one
+	constexpr size_t mnemonicWidth{ 11 };
+
+	char* formatText(char* out, const char* text, size_t width)
+	{
+		const size_t length{ std::strlen(text) };
+		std::memcpy(out, text, length);
+		out += length;
+		for (size_t i = length; i < width; ++i)
+			*out++ = ' ';
+		return out;
+	}
+
+	char* formatLabel(char* out, size_t address)
+	{
+		*out++ = 'L';
+		return format_padded(out, static_cast<unsigned>(address), 2);
+	}
+
+	//address and word columns shared by every cell line
+	char* formatCell(char* out, size_t address, int word)
+	{
+		out = format_literal(out, "    ");
+		out = format_padded(out, static_cast<unsigned>(address), 2);
+		out = format_literal(out, "  ");
+		out = format_word(out, word, 4);
+		return format_literal(out, "  ");
+	}
+
+	std::array<CellKind, memorySize> classify(const std::array<int, memorySize>& memory, const ControlFlowGraph& cfg)
+	{
+		std::array<CellKind, memorySize> kinds;
+		kinds.fill(CellKind::unused);
+
+		for (size_t address = 0; address < memorySize; ++address)
+			if (cfg.blockOf[address] != noBlock)
+				kinds[address] = CellKind::code;
+
+		//operands of reachable instructions name data unless they name code
+		for (size_t address = 0; address < memorySize; ++address)
+		{
+			const int word{ memory[address] };
+			if (kinds[address] == CellKind::code && word >= 0
+				&& word_info(word).operand == OperandKind::data && kinds[word % 100] != CellKind::code)
+				kinds[word % 100] = CellKind::data;
+		}
+		return kinds;
+	}
+}
+
+std::array<CellKind, memorySize> classify_cells(const std::array<int, memorySize>& memory)
+{
+	return classify(memory, build_cfg(memory));
+}
+
+size_t format_listing(char* buffer, const std::array<int, memorySize>& memory)
+{
+	const ControlFlowGraph cfg{ build_cfg(memory) };
+	const std::array<CellKind, memorySize> kinds{ classify(memory, cfg) };
+	char* out{ buffer };
+
+	for (size_t address = 0; address < memorySize; ++address)
+	{
+		const int word{ memory[address] };
+		const CellKind kind{ kinds[address] };
+		if (kind == CellKind::unused && word == 0)
+			continue;
+
+		if (kind != CellKind::code)
+		{
+			out = formatCell(out, address, word);
+			out = format_literal(out, "data");
+			if (kind == CellKind::unused)
+				out = format_literal(out, " ; unreferenced");
+			*out++ = '\n';
+			continue;
+		}
+
+		//label line at the start of every block
+		const BasicBlock& block = cfg.blocks[cfg.blockOf[address]];
+		if (block.start == address)
+		{
+			out = formatLabel(out, address);
+			*out++ = ':';
+			if (block.loopHeader)
+				out = format_literal(out, "  ; loop");
+			*out++ = '\n';
+		}
+
+		const InstructionInfo& info = word_info(word);
+		const size_t operand{ static_cast<size_t>(word % 100) };
+		out = formatCell(out, address, word);
+		out = formatText(out, info.mnemonic, info.operand == OperandKind::none ? 0 : mnemonicWidth);
+		if (info.operand == OperandKind::target)
+			out = formatLabel(out, operand);
+		else if (info.operand == OperandKind::data)
+			out = format_padded(out, static_cast<unsigned>(operand), 2);
+
+		//whatever a reader could miss in the plain instruction
+		if (word < 0 || !defined_opcode(static_cast<size_t>(word / 100)))
+			out = format_literal(out, " ; undefined, halts");
+		else if ((info.flags & flagWritesMemory) && kinds[operand] == CellKind::code)
+			out = format_literal(out, " ; writes code");
+		if (address + 1 == block.end && block.exitsMemory)
+			out = format_literal(out, " ; falls off memory");
+		*out++ = '\n';
+	}
+
+	return static_cast<size_t>(out - buffer);
+}
+
+std::string disassemble(const std::array<int, memorySize>& memory)
+{
+	char buffer[listingBufferSize];
+	return std::string(buffer, format_listing(buffer, memory));
+}
+
+std::string disassemble_batch(const ProgramBatch& batch)
+{
+	std::string listings;
+	char buffer[listingBufferSize];
+	std::array<int, memorySize> memory;
+
+	for (size_t i = 0; i < batch.index.size(); ++i)
+	{
+		batch.image(i, memory);
+		listings += "; ";
+		listings += batch.index[i].name;
+		listings += '\n';
+		listings.append(buffer, format_listing(buffer, memory));
+		listings += '\n';
+	}
+	return listings;
+}
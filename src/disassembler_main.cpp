@@ -0,0 +1,21 @@
+#include "disassembler.h"
+
+#include <iostream>
+
+//usage: computron-dis <program, directory or glob>
+int main(int argc, char* argv[]) {
+    if (argc != 2)
+    {
+        std::cerr << "usage: computron-dis <programs>\n";
+        return 1;
+    }
+
+    const ProgramBatch batch = load_batch(argv[1]);
+    for (const BatchError& error : batch.errors)
+        std::cerr << error.name << ": " << error.message << '\n';
+
+    //one write for the whole corpus
+    const std::string listings = disassemble_batch(batch);
+    std::cout.write(listings.data(), static_cast<std::streamsize>(listings.size()));
+    return batch.errors.empty() ? 0 : 2;
+}
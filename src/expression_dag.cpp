@@ -0,0 +1,324 @@
+#include "expression_dag.h"
+#include "interpreter.h"
+#include "isa.h"
+
+#include <bitset>
+#include <map>
+#include <tuple>
+
+namespace
+{
+	constexpr size_t noNode{ SIZE_MAX };
+
+	//builds nodes in program order, sharing equal ones and folding
+	//constant arithmetic that cannot fault
+	struct Builder
+	{
+		explicit Builder(ExpressionDag& dag) : dag{ dag } { cells.fill(noNode); }
+
+		size_t node(DagOp op, int value, size_t left, size_t right)
+		{
+			const auto key{ std::make_tuple(op, value, left, right) };
+			const auto found{ numbering.find(key) };
+			if (found != numbering.end())
+				return found->second;
+			dag.nodes.push_back({ op, value, left, right });
+			numbering.emplace(key, dag.nodes.size() - 1);
+			return dag.nodes.size() - 1;
+		}
+
+		size_t constant(int value)
+		{
+			return node(DagOp::constant, value, 0, 0);
+		}
+
+		size_t cell(size_t address)
+		{
+			if (cells[address] == noNode)
+				cells[address] = constant(dag.image[address]);
+			return cells[address];
+		}
+
+		size_t acc()
+		{
+			if (accumulator == noNode)
+				accumulator = constant(0);
+			return accumulator;
+		}
+
+		size_t arithmetic(DagOp op, size_t left, size_t right)
+		{
+			const DagNode& a{ dag.nodes[left] };
+			const DagNode& b{ dag.nodes[right] };
+			if (a.op == DagOp::constant && b.op == DagOp::constant && (op != DagOp::divide || b.value != 0))
+			{
+				long long value;
+				switch (op)
+				{
+					case DagOp::add: value = static_cast<long long>(a.value) + b.value; break;
+					case DagOp::subtract: value = static_cast<long long>(a.value) - b.value; break;
+					case DagOp::multiply: value = static_cast<long long>(a.value) * b.value; break;
+					default: value = static_cast<long long>(a.value) / b.value; break;
+				}
+				if (value >= minWord && value <= maxWord)
+					return constant(static_cast<int>(value));
+			}
+			return node(op, 0, left, right);
+		}
+
+		ExpressionDag& dag;
+		std::map<std::tuple<DagOp, int, size_t, size_t>, size_t> numbering;
+		std::array<size_t, memorySize> cells;
+		size_t accumulator{ noNode };
+	};
+
+	DagOp arithmeticOp(Command command)
+	{
+		switch (command)
+		{
+			case Command::add: return DagOp::add;
+			case Command::subtract: return DagOp::subtract;
+			case Command::multiply: return DagOp::multiply;
+			default: return DagOp::divide;
+		}
+	}
+
+	//one node across every lane of a block. faulting lanes hold zero so
+	//no later node computes with an out of range value. image constants
+	//can be any int, so lanes compute in long long like the interpreter.
+	template <typename Operation>
+	void lanes(const int* const left, const int* const right, int* const out, uint8_t* const faulted, Operation operation)
+	{
+		for (size_t lane = 0; lane < dagBlockRows; ++lane)
+		{
+			const long long value{ operation(left[lane], right[lane]) };
+			const bool fault{ value < minWord || value > maxWord };
+			faulted[lane] |= fault;
+			out[lane] = fault ? 0 : value;
+		}
+	}
+
+	void evaluateBlock(const ExpressionDag& dag, const std::vector<std::vector<int>>& rows,
+		const std::vector<size_t>& block, std::vector<int>& values, uint8_t* const faulted)
+	{
+		for (size_t index = 0; index < dag.nodes.size(); ++index)
+		{
+			const DagNode& node{ dag.nodes[index] };
+			int* const out{ &values[index * dagBlockRows] };
+			const int* const left{ &values[node.left * dagBlockRows] };
+			const int* const right{ &values[node.right * dagBlockRows] };
+			switch (node.op)
+			{
+				case DagOp::constant:
+					std::fill(out, out + dagBlockRows, node.value);
+					break;
+				case DagOp::input:
+					for (size_t lane = 0; lane < dagBlockRows; ++lane)
+						out[lane] = lane < block.size() ? rows[block[lane]][static_cast<size_t>(node.value)] : 0;
+					break;
+				case DagOp::add:
+					lanes(left, right, out, faulted, [](long long a, long long b) { return a + b; });
+					break;
+				case DagOp::subtract:
+					lanes(left, right, out, faulted, [](long long a, long long b) { return a - b; });
+					break;
+				case DagOp::multiply:
+					lanes(left, right, out, faulted, [](long long a, long long b) { return a * b; });
+					break;
+				case DagOp::divide:
+					lanes(left, right, out, faulted, [](long long a, long long b) { return b == 0 ? maxWord + 1 : a / (b == 0 ? 1 : b); });
+					break;
+			}
+		}
+	}
+
+	//a row the dag evaluates: enough inputs, all of them words
+	bool fitsDag(const ExpressionDag& dag, const std::vector<int>& row)
+	{
+		if (row.size() < dag.reads)
+			return false;
+		for (size_t i = 0; i < dag.reads; ++i)
+			if (row[i] < minWord || row[i] > maxWord)
+				return false;
+		return true;
+	}
+}
+
+ExpressionDag build_dag(const std::array<int, memorySize>& image)
+{
+	ExpressionDag dag;
+	dag.image = image;
+	Builder builder(dag);
+
+	//an unbuilt dag still carries the image for the interpreter
+	auto unbuilt = [&]
+	{
+		ExpressionDag none;
+		none.image = image;
+		return none;
+	};
+
+	std::bitset<memorySize> visited;
+	std::bitset<memorySize> written;
+
+	size_t ic{ 0 };
+	while (ic < memorySize && !visited[ic])
+	{
+		visited.set(ic);
+		++dag.executed;
+		const int word{ image[ic] };
+		const InstructionInfo& info{ word_info(word) };
+		const size_t operand{ static_cast<size_t>(word % 100) };
+		switch (info.command)
+		{
+			case Command::read:
+				builder.cells[operand] = builder.node(DagOp::input, static_cast<int>(dag.reads++), 0, 0);
+				written.set(operand);
+				break;
+			case Command::write:
+				dag.outputs.push_back(builder.cell(operand));
+				break;
+			case Command::load:
+				builder.accumulator = builder.cell(operand);
+				break;
+			case Command::store:
+				builder.cells[operand] = builder.acc();
+				written.set(operand);
+				break;
+			case Command::add:
+			case Command::subtract:
+			case Command::multiply:
+			case Command::divide:
+				builder.accumulator = builder.arithmetic(arithmeticOp(info.command), builder.acc(), builder.cell(operand));
+				break;
+			case Command::branch:
+				ic = operand;
+				continue;
+			case Command::branchNeg:
+			case Command::branchZero:
+			{
+				//only a test of a constant has one way to go
+				const DagNode& tested{ dag.nodes[builder.acc()] };
+				if (tested.op != DagOp::constant)
+					return unbuilt();
+				const bool taken{ info.command == Command::branchNeg ? tested.value < 0 : tested.value == 0 };
+				ic = taken ? operand : ic + 1;
+				continue;
+			}
+			default:
+				//a program that changes its own code is not what the trace saw
+				if ((written & visited).any())
+					return unbuilt();
+				for (size_t address = 0; address < memorySize; ++address)
+					if (written[address])
+						dag.stores.emplace_back(address, builder.cells[address]);
+				dag.accumulator = builder.acc();
+				dag.halt = ic;
+				dag.built = true;
+				return dag;
+		}
+		++ic;
+	}
+	return unbuilt();
+}
+
+DagBatchResult run_dag_batch(const ExpressionDag& dag, const std::vector<std::vector<int>>& rows, uint64_t budget)
+{
+	DagBatchResult result;
+	result.rows = rows.size();
+	result.scalarIndex.assign(rows.size(), SIZE_MAX);
+
+	std::vector<size_t> scalar;
+	if (!dag.built || budget < dag.executed)
+	{
+		for (size_t row = 0; row < rows.size(); ++row)
+			scalar.push_back(row);
+	}
+	else
+	{
+		//the nodes every column copies, in column order
+		std::vector<size_t> kept;
+		for (const auto& [address, node] : dag.stores)
+			kept.push_back(node);
+		kept.push_back(dag.accumulator);
+		kept.insert(kept.end(), dag.outputs.begin(), dag.outputs.end());
+		result.columns.resize(kept.size() * rows.size());
+
+		std::vector<int> values(dag.nodes.size() * dagBlockRows);
+		std::array<uint8_t, dagBlockRows> faulted;
+		std::vector<size_t> block;
+		block.reserve(dagBlockRows);
+
+		auto finishBlock = [&]
+		{
+			faulted.fill(0);
+			evaluateBlock(dag, rows, block, values, faulted.data());
+			for (size_t lane = 0; lane < block.size(); ++lane)
+			{
+				if (faulted[lane])
+					scalar.push_back(block[lane]);
+				else
+					for (size_t column = 0; column < kept.size(); ++column)
+						result.columns[column * rows.size() + block[lane]] = values[kept[column] * dagBlockRows + lane];
+			}
+			block.clear();
+		};
+
+		for (size_t row = 0; row < rows.size(); ++row)
+		{
+			if (!fitsDag(dag, rows[row]))
+			{
+				scalar.push_back(row);
+				continue;
+			}
+			block.push_back(row);
+			if (block.size() == dagBlockRows)
+				finishBlock();
+		}
+		if (!block.empty())
+			finishBlock();
+	}
+
+	for (const size_t row : scalar)
+	{
+		ScalarRow& run{ result.scalar.emplace_back() };
+		run.state.memory = dag.image;
+		OutputObserver observer(&run.outputs);
+		run.termination = ::run(run.state, rows[row], budget, &run.executed, observer);
+		result.scalarIndex[row] = result.scalar.size() - 1;
+	}
+	return result;
+}
+
+Termination batch_row(const ExpressionDag& dag, const DagBatchResult& batch, size_t row,
+	MachineState* const statePtr, uint64_t* const executedPtr, std::vector<int>* const outputsPtr)
+{
+	if (batch.scalarIndex[row] != SIZE_MAX)
+	{
+		const ScalarRow& run{ batch.scalar[batch.scalarIndex[row]] };
+		*statePtr = run.state;
+		*executedPtr += run.executed;
+		if (outputsPtr)
+			outputsPtr->insert(outputsPtr->end(), run.outputs.begin(), run.outputs.end());
+		return run.termination;
+	}
+
+	//the state run<>() leaves at the halt
+	auto column = [&](size_t index) { return batch.columns[index * batch.rows + row]; };
+	MachineState& state{ *statePtr };
+	state = MachineState{};
+	state.memory = dag.image;
+	for (size_t store = 0; store < dag.stores.size(); ++store)
+		state.memory[dag.stores[store].first] = column(store);
+	state.accumulator = column(dag.stores.size());
+	state.instructionCounter = dag.halt;
+	state.instructionRegister = dag.image[dag.halt];
+	state.operationCode = static_cast<size_t>(state.instructionRegister / 100);
+	state.operand = static_cast<size_t>(state.instructionRegister % 100);
+	state.inputIndex = dag.reads;
+	*executedPtr += dag.executed;
+	if (outputsPtr)
+		for (size_t output = 0; output < dag.outputs.size(); ++output)
+			outputsPtr->push_back(column(dag.stores.size() + 1 + output));
+	return Termination::halted;
+}
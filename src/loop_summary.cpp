@@ -0,0 +1,426 @@
+#include "loop_summary.h"
+#include "cfg.h"
+#include "interpreter.h"
+#include "isa.h"
+#include "verifier.h"
+
+#include <algorithm>
+#include <bitset>
+
+namespace
+{
+	constexpr size_t accumulator{ memorySize };
+	constexpr size_t variableCount{ memorySize + 1 };
+	constexpr size_t unresolved{ SIZE_MAX };
+	constexpr size_t maxDegree{ 3 };
+	constexpr long long weightLimit{ 64 }; //sum of coefficient magnitudes in a form
+
+	//iterations one summary may skip once values change. a polynomial of
+	//degree two or more leaves the word range within a few hundred
+	//iterations, so neither cap binds in practice; they keep every
+	//evaluation inside long long.
+	constexpr uint64_t linearLimit{ 1 << 16 };
+	constexpr uint64_t scanLimit{ 1 << 10 };
+
+	using DenseForm = std::array<long long, variableCount>;
+
+	//coefficients of C(k, 0) to C(k, maxDegree), the value after k iterations
+	using Polynomial = std::array<long long, maxDegree + 1>;
+
+	enum class Walk { header, conditional, failed };
+
+	//follows straight-line code and unconditional branches from address
+	//until it reaches the header again or a conditional branch
+	Walk walk(const std::array<int, memorySize>& image, size_t address, size_t header,
+		std::vector<size_t>& path, std::bitset<memorySize>& visited)
+	{
+		while (true)
+		{
+			if (address == header && !path.empty())
+				return Walk::header;
+			if (address >= memorySize || visited[address])
+				return Walk::failed;
+			visited.set(address);
+			path.push_back(address);
+
+			const int word{ image[address] };
+			switch (word_info(word).command)
+			{
+				case Command::load:
+				case Command::store:
+				case Command::add:
+				case Command::subtract:
+					++address;
+					break;
+				case Command::branch:
+					address = static_cast<size_t>(word % 100);
+					break;
+				case Command::branchNeg:
+				case Command::branchZero:
+					return Walk::conditional;
+				default: //input, output, multiply and divide do not summarize
+					return Walk::failed;
+			}
+		}
+	}
+
+	long long weight(const DenseForm& form)
+	{
+		long long total{ 0 };
+		for (const long long coefficient : form)
+			total += coefficient < 0 ? -coefficient : coefficient;
+		return total;
+	}
+
+	LinearForm sparse(const DenseForm& form)
+	{
+		LinearForm result;
+		for (size_t variable = 0; variable < variableCount; ++variable)
+			if (form[variable] != 0)
+				result.emplace_back(variable, form[variable]);
+		return result;
+	}
+
+	//symbolically runs one iteration and solves the recurrences it sets up
+	bool summarize(const std::array<int, memorySize>& image, size_t header, LoopSummary* const loopPtr)
+	{
+		std::vector<size_t> path;
+		std::bitset<memorySize> visited;
+		if (walk(image, header, header, path, visited) != Walk::conditional)
+			return false;
+
+		//exactly one side of the test must come back without another test
+		const size_t test{ path.back() };
+		const size_t sides[]{ static_cast<size_t>(image[test] % 100), test + 1 };
+		std::vector<size_t> cycle;
+		size_t continuing{ 0 };
+		size_t returning{ 0 };
+		for (size_t side = 0; side < 2; ++side)
+		{
+			std::vector<size_t> sidePath{ path };
+			std::bitset<memorySize> sideVisited{ visited };
+			if (walk(image, sides[side], header, sidePath, sideVisited) == Walk::header)
+			{
+				cycle = std::move(sidePath);
+				continuing = side;
+				++returning;
+			}
+		}
+		if (returning != 1)
+			return false;
+
+		LoopSummary loop;
+		loop.header = header;
+		loop.length = cycle.size();
+		loop.test = test;
+		loop.latch = cycle.back();
+		loop.exitWhenTaken = continuing == 1;
+
+		std::vector<DenseForm> forms(variableCount);
+		for (size_t variable = 0; variable < variableCount; ++variable)
+		{
+			forms[variable].fill(0);
+			forms[variable][variable] = 1;
+		}
+
+		for (const size_t address : cycle)
+		{
+			const size_t operand{ static_cast<size_t>(image[address] % 100) };
+			DenseForm& ac{ forms[accumulator] };
+			switch (word_info(image[address]).command)
+			{
+				case Command::load:
+					ac = forms[operand];
+					break;
+				case Command::store:
+					forms[operand] = ac;
+					break;
+				case Command::add:
+				case Command::subtract:
+				{
+					const long long sign{ word_info(image[address]).command == Command::add ? 1 : -1 };
+					const DenseForm cell{ forms[operand] };
+					for (size_t variable = 0; variable < variableCount; ++variable)
+						ac[variable] += sign * cell[variable];
+					if (weight(ac) > weightLimit)
+						return false;
+					loop.results.push_back(sparse(ac));
+					break;
+				}
+				case Command::branchNeg:
+				case Command::branchZero:
+					loop.condition = sparse(ac);
+					break;
+				default:
+					break;
+			}
+		}
+
+		//unchanged variables are invariant, a variable that only adds
+		//already solved ones to itself is one degree above the highest
+		std::array<size_t, variableCount> degree;
+		degree.fill(unresolved);
+		for (size_t variable = 0; variable < variableCount; ++variable)
+		{
+			DenseForm unit{};
+			unit[variable] = 1;
+			if (forms[variable] == unit)
+				degree[variable] = 0;
+		}
+		for (bool progress = true; progress;)
+		{
+			progress = false;
+			for (size_t variable = 0; variable < variableCount; ++variable)
+			{
+				if (degree[variable] != unresolved || forms[variable][variable] != 1)
+					continue;
+				DenseForm step{ forms[variable] };
+				step[variable] = 0;
+				size_t highest{ 0 };
+				bool solvable{ true };
+				for (size_t other = 0; other < variableCount; ++other)
+				{
+					if (step[other] == 0)
+						continue;
+					solvable = solvable && degree[other] != unresolved;
+					highest = std::max(highest, degree[other]);
+				}
+				if (!solvable || highest + 1 > maxDegree)
+					continue;
+				degree[variable] = highest + 1;
+				loop.degree = std::max(loop.degree, highest + 1);
+				loop.steps.emplace_back(variable, sparse(step));
+				progress = true;
+			}
+		}
+		for (size_t variable = 0; variable < variableCount; ++variable)
+			if (degree[variable] == unresolved)
+				loop.derived.emplace_back(variable, sparse(forms[variable]));
+
+		//a derived variable is only known after its iteration, so nothing may read it
+		auto solved = [&](const LinearForm& form)
+		{
+			return std::all_of(form.begin(), form.end(),
+				[&](const auto& term) { return degree[term.first] != unresolved; });
+		};
+		if (!solved(loop.condition) || !std::all_of(loop.results.begin(), loop.results.end(), solved))
+			return false;
+		for (const auto& [variable, form] : loop.derived)
+			if (!solved(form))
+				return false;
+
+		*loopPtr = std::move(loop);
+		return true;
+	}
+
+	size_t effectiveDegree(const Polynomial& polynomial)
+	{
+		size_t degree{ maxDegree };
+		while (degree > 0 && polynomial[degree] == 0)
+			--degree;
+		return degree;
+	}
+
+	long long evaluate(const Polynomial& polynomial, uint64_t k)
+	{
+		long long value{ polynomial[0] };
+		long long binomial{ 1 };
+		const size_t degree{ effectiveDegree(polynomial) };
+		for (size_t j = 1; j <= degree; ++j)
+		{
+			binomial = binomial * (static_cast<long long>(k) - static_cast<long long>(j) + 1) / static_cast<long long>(j);
+			value += polynomial[j] * binomial;
+		}
+		return value;
+	}
+
+	Polynomial combine(const LinearForm& form, const std::array<Polynomial, variableCount>& polynomials)
+	{
+		Polynomial result{};
+		for (const auto& [variable, coefficient] : form)
+			for (size_t j = 0; j <= maxDegree; ++j)
+				result[j] += coefficient * polynomials[variable][j];
+		return result;
+	}
+
+	bool inRange(long long value)
+	{
+		return value >= minWord && value <= maxWord;
+	}
+
+	//first k below limit where predicate holds, trying every k
+	template <typename Predicate>
+	uint64_t scan(const Polynomial& polynomial, uint64_t limit, Predicate predicate)
+	{
+		for (uint64_t k = 0; k < limit; ++k)
+			if (predicate(evaluate(polynomial, k)))
+				return k;
+		return limit;
+	}
+
+	//first iteration whose result leaves the word range, at most limit
+	uint64_t firstFault(const Polynomial& result, uint64_t limit)
+	{
+		if (!inRange(result[0]))
+			return 0;
+		switch (effectiveDegree(result))
+		{
+			case 0:
+				return limit;
+			case 1:
+			{
+				const long long slope{ result[1] };
+				const long long k{ slope > 0 ? (maxWord - result[0]) / slope + 1 : (result[0] - minWord) / -slope + 1 };
+				return std::min(static_cast<uint64_t>(k), limit);
+			}
+			default:
+				return scan(result, limit, [](long long value) { return !inRange(value); });
+		}
+	}
+
+	//first iteration whose test leaves the loop, at most limit
+	uint64_t firstExit(const LoopSummary& loop, Command test, const Polynomial& condition, uint64_t limit)
+	{
+		auto exits = [&](long long value)
+		{
+			const bool taken{ test == Command::branchNeg ? value < 0 : value == 0 };
+			return taken == loop.exitWhenTaken;
+		};
+		if (exits(condition[0]))
+			return 0;
+
+		const long long start{ condition[0] };
+		const long long slope{ condition[1] };
+		switch (effectiveDegree(condition))
+		{
+			case 0:
+				return limit;
+			case 1:
+				if (test == Command::branchZero)
+				{
+					if (!loop.exitWhenTaken) //leaves as soon as it moves off zero
+						return std::min(uint64_t{ 1 }, limit);
+					if (-start % slope != 0 || -start / slope < 0)
+						return limit;
+					return std::min(static_cast<uint64_t>(-start / slope), limit);
+				}
+				if (loop.exitWhenTaken) //leaves once negative
+					return slope < 0 ? std::min(static_cast<uint64_t>(start / -slope + 1), limit) : limit;
+				return slope > 0 ? std::min(static_cast<uint64_t>((-start + slope - 1) / slope), limit) : limit;
+			default:
+				return scan(condition, limit, exits);
+		}
+	}
+
+	int& variableOf(MachineState& state, size_t variable)
+	{
+		return variable == accumulator ? state.accumulator : state.memory[variable];
+	}
+}
+
+LoopSummaries summarize_loops(const std::array<int, memorySize>& image)
+{
+	LoopSummaries summaries;
+	summaries.loopAt.fill(SIZE_MAX);
+
+	const Verification verification{ verify_program(image) };
+	if (!verification.verified || verification.codeWrites.any())
+		return summaries;
+
+	const ControlFlowGraph cfg{ build_cfg(image) };
+	for (const Loop& cfgLoop : cfg.loops)
+	{
+		const size_t header{ cfg.blocks[cfgLoop.header].start };
+		LoopSummary loop;
+		if (summaries.loopAt[header] == SIZE_MAX && summarize(image, header, &loop))
+		{
+			summaries.loopAt[header] = summaries.loops.size();
+			summaries.loops.push_back(std::move(loop));
+		}
+	}
+	return summaries;
+}
+
+uint64_t skip_iterations(const LoopSummary& loop, MachineState& state, uint64_t budget)
+{
+	std::array<Polynomial, variableCount> polynomials{};
+	for (size_t variable = 0; variable < variableCount; ++variable)
+		polynomials[variable][0] = variableOf(state, variable);
+
+	//summing a polynomial over the iterations raises its degree by one
+	size_t degree{ 0 };
+	for (const auto& [variable, form] : loop.steps)
+	{
+		const Polynomial step{ combine(form, polynomials) };
+		Polynomial& polynomial{ polynomials[variable] };
+		for (size_t j = 0; j < maxDegree; ++j)
+			polynomial[j + 1] = step[j];
+		degree = std::max(degree, effectiveDegree(polynomial));
+	}
+
+	uint64_t limit{ budget / loop.length };
+	if (degree == 1)
+		limit = std::min(limit, linearLimit);
+	else if (degree > 1)
+		limit = std::min(limit, scanLimit);
+	for (const LinearForm& result : loop.results)
+		limit = firstFault(combine(result, polynomials), limit);
+
+	const int testWord{ state.memory[loop.test] };
+	const uint64_t iterations{ firstExit(loop, word_info(testWord).command, combine(loop.condition, polynomials), limit) };
+	if (iterations == 0)
+		return 0;
+
+	//every new value is computed before any is assigned
+	std::vector<std::pair<size_t, int>> values;
+	for (const auto& [variable, form] : loop.steps)
+		values.emplace_back(variable, static_cast<int>(evaluate(polynomials[variable], iterations)));
+	for (const auto& [variable, form] : loop.derived)
+		values.emplace_back(variable, static_cast<int>(evaluate(combine(form, polynomials), iterations - 1)));
+	for (const auto& [variable, value] : values)
+		variableOf(state, variable) = value;
+
+	//registers as the last instruction of the iteration left them
+	state.instructionCounter = loop.header;
+	state.instructionRegister = state.memory[loop.latch];
+	state.operationCode = static_cast<size_t>(state.instructionRegister / 100);
+	state.operand = static_cast<size_t>(state.instructionRegister % 100);
+	return iterations;
+}
+
+Termination run_summarized(MachineState& state, const std::vector<int>& inputs, uint64_t budget,
+	uint64_t* const executedPtr, const LoopSummaries& summaries, std::vector<int>* const outputsPtr)
+{
+	OutputObserver observer(outputsPtr);
+	Command command;
+	uint64_t done{ 0 };
+	while (done < budget)
+	{
+		const size_t ic{ state.instructionCounter };
+		if (ic < memorySize && summaries.loopAt[ic] != SIZE_MAX)
+		{
+			const LoopSummary& loop{ summaries.loops[summaries.loopAt[ic]] };
+			done += skip_iterations(loop, state, budget - done) * loop.length;
+			if (done == budget)
+				break;
+		}
+
+		if (!execute_instruction(state.memory, &state.accumulator,
+			&state.instructionCounter, &state.instructionRegister,
+			&state.operationCode, &state.operand,
+			inputs, &state.inputIndex, &command, observer))
+		{
+			*executedPtr += done;
+			return Termination::faulted;
+		}
+		++done;
+		if (command == Command::halt)
+		{
+			*executedPtr += done;
+			return Termination::halted;
+		}
+	}
+
+	*executedPtr += done;
+	return Termination::budgetExceeded;
+}
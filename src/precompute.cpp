@@ -0,0 +1,63 @@
+#include "precompute.h"
+#include "interpreter.h"
+#include "isa.h"
+
+Precomputed precompute(const std::array<int, memorySize>& image, uint64_t limit)
+{
+	Precomputed result;
+	result.image = image;
+	MachineState& state = result.state;
+	state.memory = image;
+
+	OutputObserver observer(&result.outputs);
+	const std::vector<int> noInputs;
+	Command command;
+	for (; result.executed < limit; ++result.executed)
+	{
+		//read is the only instruction whose effect depends on the inputs
+		const size_t ic{ state.instructionCounter };
+		if (ic < memorySize && word_info(state.memory[ic]).command == Command::read)
+			return result;
+
+		if (!execute_instruction(state.memory, &state.accumulator,
+			&state.instructionCounter, &state.instructionRegister,
+			&state.operationCode, &state.operand,
+			noInputs, &state.inputIndex, &command, observer))
+		{
+			result.termination = Termination::faulted;
+			result.complete = true;
+			return result;
+		}
+		if (command == Command::halt)
+		{
+			++result.executed;
+			result.termination = Termination::halted;
+			result.complete = true;
+			return result;
+		}
+	}
+	return result;
+}
+
+Termination run_precomputed(const Precomputed& precomputed, const std::vector<int>& inputs, uint64_t budget,
+	MachineState* const statePtr, uint64_t* const executedPtr, std::vector<int>* const outputsPtr)
+{
+	OutputObserver observer(outputsPtr);
+
+	//a fault takes one more instruction of budget than it counts
+	const bool faulted{ precomputed.termination == Termination::faulted };
+	if (budget < precomputed.executed + (faulted ? 1 : 0))
+	{
+		*statePtr = MachineState{};
+		statePtr->memory = precomputed.image;
+		return run(*statePtr, inputs, budget, executedPtr, observer);
+	}
+
+	*statePtr = precomputed.state;
+	*executedPtr += precomputed.executed;
+	if (outputsPtr)
+		outputsPtr->insert(outputsPtr->end(), precomputed.outputs.begin(), precomputed.outputs.end());
+	if (precomputed.complete)
+		return precomputed.termination;
+	return run(*statePtr, inputs, budget - precomputed.executed, executedPtr, observer);
+}
@@ -0,0 +1,258 @@
+#include "replay.h"
+#include "container.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+	constexpr char magic[8]{ 'C', 'T', 'R', 'N', 'L', 'O', 'G', '1' };
+
+	//little-endian stream helpers
+	void put(std::ostream& out, uint64_t value, size_t bytes)
+	{
+		char buffer[8];
+		for (size_t i = 0; i < bytes; ++i)
+			buffer[i] = static_cast<char>(value >> (8 * i));
+		out.write(buffer, static_cast<std::streamsize>(bytes));
+	}
+
+	uint64_t get(std::istream& in, size_t bytes)
+	{
+		unsigned char buffer[8];
+		if (!in.read(reinterpret_cast<char*>(buffer), static_cast<std::streamsize>(bytes)))
+			throw std::runtime_error("invalid_input");
+
+		uint64_t value{ 0 };
+		for (size_t i = 0; i < bytes; ++i)
+			value |= static_cast<uint64_t>(buffer[i]) << (8 * i);
+		return value;
+	}
+
+	void putInt(std::ostream& out, long long value)
+	{
+		put(out, static_cast<uint32_t>(value), 4);
+	}
+
+	int getInt(std::istream& in)
+	{
+		return static_cast<int32_t>(get(in, 4));
+	}
+
+	void putWords(std::ostream& out, const std::vector<int>& words)
+	{
+		put(out, words.size(), 4);
+		for (int word : words)
+			putInt(out, word);
+	}
+
+	//a count of items that must each take at least itemBytes more of the
+	//stream, so a corrupt count is refused before anything is allocated
+	size_t getCount(std::istream& in, size_t itemBytes)
+	{
+		const uint64_t count{ get(in, 4) };
+		const std::streamoff position{ in.tellg() };
+		if (position < 0)
+			return count; //unseekable, items are read one at a time below
+
+		in.seekg(0, std::ios::end);
+		const std::streamoff end{ in.tellg() };
+		in.seekg(position);
+		if (!in || count > static_cast<uint64_t>(end - position) / itemBytes)
+			throw std::runtime_error("invalid_input");
+		return count;
+	}
+
+	std::vector<int> getWords(std::istream& in)
+	{
+		const size_t count{ getCount(in, 4) };
+		std::vector<int> words;
+		for (size_t i = 0; i < count; ++i)
+			words.push_back(getInt(in));
+		return words;
+	}
+
+	//registers, then memory as changes against the image
+	void putState(std::ostream& out, const MachineState& state, const std::array<int, memorySize>& image)
+	{
+		putInt(out, state.accumulator);
+		put(out, state.instructionCounter, 1);
+		putInt(out, state.instructionRegister);
+		putInt(out, static_cast<int64_t>(state.operationCode));
+		putInt(out, static_cast<int64_t>(state.operand));
+		put(out, state.inputIndex, 4);
+
+		const std::vector<CellChange> changes{ diff_memory(image, state.memory) };
+		put(out, changes.size(), 1);
+		for (const CellChange& change : changes)
+		{
+			put(out, change.address, 1);
+			putInt(out, change.value);
+		}
+	}
+
+	MachineState getState(std::istream& in, const std::array<int, memorySize>& image)
+	{
+		MachineState state;
+		state.accumulator = getInt(in);
+		state.instructionCounter = get(in, 1);
+		state.instructionRegister = getInt(in);
+		state.operationCode = static_cast<size_t>(static_cast<int64_t>(getInt(in)));
+		state.operand = static_cast<size_t>(static_cast<int64_t>(getInt(in)));
+		state.inputIndex = get(in, 4);
+
+		state.memory = image;
+		const size_t changes{ get(in, 1) };
+		for (size_t i = 0; i < changes; ++i)
+		{
+			const size_t address{ get(in, 1) };
+			if (address >= memorySize)
+				throw std::runtime_error("invalid_input");
+			state.memory[address] = getInt(in);
+		}
+		return state;
+	}
+
+	//smallest encoded state: registers and an empty change count
+	constexpr size_t stateBytes{ 4 + 1 + 4 + 4 + 4 + 4 + 1 };
+
+	bool sameCheckpoint(const Checkpoint& a, const Checkpoint& b)
+	{
+		return a.executed == b.executed && a.outputCount == b.outputCount && a.state == b.state;
+	}
+}
+
+RunLog record_run(const std::array<int, memorySize>& image, const std::vector<int>& inputs,
+	uint64_t checkpointInterval, uint64_t budget)
+{
+	RunLog log;
+	log.programHash = program_hash(image);
+	log.checkpointInterval = checkpointInterval;
+	log.termination = Termination::budgetExceeded;
+
+	MachineState& state = log.final;
+	state.memory = image;
+
+	try
+	{
+		while (log.executed < budget)
+		{
+			if (checkpointInterval != 0 && log.executed % checkpointInterval == 0)
+				log.checkpoints.push_back({ log.executed, state, log.outputs.size() });
+
+			const Command command{ step(state, inputs) };
+			++log.executed;
+
+			if (command == Command::write)
+				log.outputs.push_back(state.memory[state.operand]);
+			else if (command == Command::halt)
+			{
+				log.termination = Termination::halted;
+				break;
+			}
+		}
+	}
+	catch (const std::runtime_error&)
+	{
+		//the faulting instruction did not complete
+		log.termination = Termination::faulted;
+	}
+
+	//only inputs that were actually read are needed to reproduce the run
+	log.inputs.assign(inputs.begin(), inputs.begin() + static_cast<std::ptrdiff_t>(state.inputIndex));
+	return log;
+}
+
+bool replay_run(const std::array<int, memorySize>& image, const RunLog& log)
+{
+	if (program_hash(image) != log.programHash)
+		return false;
+
+	//same budget again, with room for the faulting or halting step
+	const uint64_t budget{ log.termination == Termination::budgetExceeded ? log.executed : log.executed + 1 };
+	const RunLog again{ record_run(image, log.inputs, log.checkpointInterval, budget) };
+
+	if (again.executed != log.executed || again.termination != log.termination
+		|| again.inputs != log.inputs || again.outputs != log.outputs || !(again.final == log.final)
+		|| again.checkpoints.size() != log.checkpoints.size())
+		return false;
+
+	for (size_t i = 0; i < log.checkpoints.size(); ++i)
+		if (!sameCheckpoint(again.checkpoints[i], log.checkpoints[i]))
+			return false;
+
+	return true;
+}
+
+MachineState seek_run(const std::array<int, memorySize>& image, const RunLog& log, uint64_t executed)
+{
+	if (executed >= log.executed)
+		return log.final;
+
+	//latest checkpoint at or before the target
+	MachineState state;
+	state.memory = image;
+	uint64_t position{ 0 };
+	for (const Checkpoint& checkpoint : log.checkpoints)
+	{
+		if (checkpoint.executed > executed)
+			break;
+		state = checkpoint.state;
+		position = checkpoint.executed;
+	}
+
+	//the target lies before the end, so these steps cannot halt or fault
+	for (; position < executed; ++position)
+		step(state, log.inputs);
+	return state;
+}
+
+void write_run_log(std::ostream& out, const RunLog& log, const std::array<int, memorySize>& image)
+{
+	out.write(magic, sizeof(magic));
+	put(out, log.programHash, 8);
+	put(out, log.executed, 8);
+	put(out, static_cast<uint8_t>(log.termination), 1);
+	put(out, log.checkpointInterval, 8);
+	putWords(out, log.inputs);
+	putWords(out, log.outputs);
+	putState(out, log.final, image);
+
+	put(out, log.checkpoints.size(), 4);
+	for (const Checkpoint& checkpoint : log.checkpoints)
+	{
+		put(out, checkpoint.executed, 8);
+		put(out, checkpoint.outputCount, 4);
+		putState(out, checkpoint.state, image);
+	}
+}
+
+RunLog read_run_log(std::istream& in, const std::array<int, memorySize>& image)
+{
+	char header[sizeof(magic)];
+	if (!in.read(header, sizeof(header)) || !std::equal(header, header + sizeof(header), magic))
+		throw std::runtime_error("invalid_input");
+
+	RunLog log;
+	log.programHash = get(in, 8);
+	log.executed = get(in, 8);
+	log.termination = static_cast<Termination>(get(in, 1));
+	log.checkpointInterval = get(in, 8);
+	log.inputs = getWords(in);
+	log.outputs = getWords(in);
+	log.final = getState(in, image);
+
+	//checkpoints are taken before steps, at most one per instruction run
+	const size_t checkpoints{ getCount(in, 8 + 4 + stateBytes) };
+	if (checkpoints > log.executed + 1)
+		throw std::runtime_error("invalid_input");
+	for (size_t i = 0; i < checkpoints; ++i)
+	{
+		Checkpoint checkpoint;
+		checkpoint.executed = get(in, 8);
+		checkpoint.outputCount = get(in, 4);
+		checkpoint.state = getState(in, image);
+		log.checkpoints.push_back(checkpoint);
+	}
+	return log;
+}
@@ -0,0 +1,138 @@
+#include "scheduler.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+	constexpr size_t strideOne{ 1 << 16 }; //stride of a priority 1 job
+}
+
+Scheduler::Scheduler(size_t workers, size_t quantum)
+	: quantum{ std::max<size_t>(quantum, 1) }
+{
+	//always keep at least one worker
+	workers = std::max<size_t>(workers, 1);
+	for (size_t i = 0; i < workers; ++i)
+		threads.emplace_back(&Scheduler::work, this);
+}
+
+Scheduler::~Scheduler()
+{
+	//wake every worker and let them exit
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	workReady.notify_all();
+
+	for (std::thread& thread : threads)
+		thread.join();
+}
+
+size_t Scheduler::submit(const std::array<int, memorySize>& memory, std::vector<int> inputs,
+	unsigned priority, size_t budget)
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	//new jobs start at the current pass so they neither starve nor get starved
+	Job& job = jobs.emplace_back();
+	job.result.state.memory = memory;
+	job.inputs = std::move(inputs);
+	//priorities above strideOne would give stride 0 and a pass that never moves
+	job.stride = std::max<size_t>(strideOne / std::max(priority, 1u), 1);
+	job.pass = globalPass;
+	job.budget = budget;
+
+	runQueue.push(&job);
+	++unfinished;
+	workReady.notify_one();
+
+	return jobs.size() - 1;
+}
+
+void Scheduler::wait()
+{
+	std::unique_lock<std::mutex> guard(lock);
+	allDone.wait(guard, [this] { return unfinished == 0; });
+}
+
+const JobResult& Scheduler::result(size_t id) const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	if (id >= jobs.size())
+		throw std::runtime_error("invalid_input");
+
+	return jobs[id].result;
+}
+
+void Scheduler::work()
+{
+	std::unique_lock<std::mutex> guard(lock);
+
+	while (true)
+	{
+		workReady.wait(guard, [this] { return stopping || !runQueue.empty(); });
+		if (stopping)
+			return;
+
+		//take the job with the lowest pass
+		Job& job = *runQueue.top();
+		runQueue.pop();
+		globalPass = job.pass;
+
+		//run outside the lock, only this worker touches the job now
+		guard.unlock();
+		const size_t before{ job.result.executed };
+		runQuantum(job);
+		guard.lock();
+
+		//charge the job for what it actually ran
+		job.pass += job.stride * (job.result.executed - before);
+		if (job.result.status == JobStatus::pending)
+		{
+			runQueue.push(&job);
+			workReady.notify_one();
+		}
+		else
+		{
+			job.result.finishOrder = finished++;
+			if (--unfinished == 0)
+				allDone.notify_all();
+		}
+	}
+}
+
+void Scheduler::runQuantum(Job& job)
+{
+	JobResult& result = job.result;
+	++result.quanta;
+
+	//limit this slice by the remaining budget
+	size_t slice{ quantum };
+	if (job.budget != 0)
+		slice = std::min(slice, job.budget - result.executed);
+
+	try
+	{
+		for (size_t i = 0; i < slice; ++i)
+		{
+			//a faulting step is not counted, like the reference run
+			const Command command{ step(result.state, job.inputs) };
+			++result.executed;
+			if (command == Command::halt)
+			{
+				result.status = JobStatus::halted;
+				return;
+			}
+		}
+	}
+	catch (const std::runtime_error&)
+	{
+		result.status = JobStatus::faulted;
+		return;
+	}
+
+	if (job.budget != 0 && result.executed >= job.budget)
+		result.status = JobStatus::budgetExceeded;
+}
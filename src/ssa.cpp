@@ -0,0 +1,1014 @@
+#include "ssa.h"
+#include "cfg.h"
+#include "interpreter.h"
+#include "isa.h"
+#include "verifier.h"
+
+#include <algorithm>
+#include <bitset>
+#include <map>
+#include <tuple>
+
+namespace
+{
+	constexpr size_t noValue{ SIZE_MAX };
+	constexpr size_t variableCount{ memorySize + 1 };
+	constexpr size_t blockLimit{ memorySize + 1 }; //block 0 and one per address at most
+
+	bool arithmetic(IrOp op)
+	{
+		return op == IrOp::add || op == IrOp::subtract || op == IrOp::multiply || op == IrOp::divide;
+	}
+
+	//result of an arithmetic op, false when the machine would fault
+	bool evaluate(IrOp op, long long a, long long b, int* const resultPtr)
+	{
+		long long result;
+		switch (op)
+		{
+			case IrOp::add: result = a + b; break;
+			case IrOp::subtract: result = a - b; break;
+			case IrOp::multiply: result = a * b; break;
+			default:
+				if (b == 0)
+					return false;
+				result = a / b;
+		}
+		if (result < minWord || result > maxWord)
+			return false;
+		*resultPtr = static_cast<int>(result);
+		return true;
+	}
+
+	//ssa construction after Braun et al., "Simple and Efficient
+	//Construction of Static Single Assignment Form"
+	class Builder
+	{
+	public:
+		explicit Builder(IrProgram& program)
+			: program{ program }, definitions(program.blocks.size()), sealed(program.blocks.size(), false),
+			filled(program.blocks.size(), false), incomplete(program.blocks.size())
+		{
+			for (auto& row : definitions)
+				row.fill(noValue);
+		}
+
+		size_t add(size_t block, IrOp op, std::vector<size_t> operands = {}, int constant = 0)
+		{
+			program.values.push_back({ op, constant, std::move(operands), block });
+			program.blocks[block].values.push_back(program.values.size() - 1);
+			return program.values.size() - 1;
+		}
+
+		void write(size_t variable, size_t block, size_t value) { definitions[block][variable] = value; }
+
+		size_t read(size_t variable, size_t block)
+		{
+			if (definitions[block][variable] != noValue)
+				return definitions[block][variable];
+
+			size_t value;
+			if (block == 0)
+			{
+				//before the first instruction memory holds the image
+				value = add(0, IrOp::constant, {}, variable == accumulatorVariable ? 0 : program.image[variable]);
+			}
+			else if (!sealed[block])
+			{
+				value = add(block, IrOp::phi);
+				incomplete[block].push_back({ variable, value });
+			}
+			else if (program.blocks[block].predecessors.size() == 1)
+				value = read(variable, program.blocks[block].predecessors[0]);
+			else
+			{
+				//define the phi first so a loop back to here finds it
+				value = add(block, IrOp::phi);
+				write(variable, block, value);
+				addOperands(variable, value);
+			}
+			write(variable, block, value);
+			return value;
+		}
+
+		void fill(size_t block) { filled[block] = true; }
+
+		//seals every block whose predecessors have all been filled
+		void sealReady()
+		{
+			for (size_t block = 0; block < program.blocks.size(); ++block)
+			{
+				if (sealed[block])
+					continue;
+				const std::vector<size_t>& predecessors = program.blocks[block].predecessors;
+				if (std::all_of(predecessors.begin(), predecessors.end(), [&](size_t p) { return filled[p]; }))
+				{
+					sealed[block] = true;
+					for (const auto& [variable, phi] : incomplete[block])
+						addOperands(variable, phi);
+					incomplete[block].clear();
+				}
+			}
+		}
+
+	private:
+		void addOperands(size_t variable, size_t phi)
+		{
+			const size_t block{ program.values[phi].block };
+			for (size_t predecessor : program.blocks[block].predecessors)
+			{
+				const size_t operand{ read(variable, predecessor) };
+				program.values[phi].operands.push_back(operand);
+			}
+		}
+
+		IrProgram& program;
+		std::vector<std::array<size_t, variableCount>> definitions;
+		std::vector<bool> sealed;
+		std::vector<bool> filled;
+		std::vector<std::vector<std::pair<size_t, size_t>>> incomplete;
+	};
+
+	size_t resolve(const IrProgram& program, size_t value)
+	{
+		while (program.values[value].op == IrOp::copy)
+			value = program.values[value].operands[0];
+		return value;
+	}
+
+	bool conditional(const IrBlock& block)
+	{
+		return block.exit == IrExit::branchNeg || block.exit == IrExit::branchZero;
+	}
+
+	//every value a block reads outside its value list
+	template <typename Visit>
+	void forEachRoot(IrBlock& block, Visit visit)
+	{
+		if (conditional(block))
+			visit(block.condition);
+		for (auto& [variable, value] : block.finals)
+			visit(value);
+	}
+
+	bool propagateCopies(IrProgram& program)
+	{
+		bool changed{ false };
+		auto replace = [&](size_t& operand)
+		{
+			const size_t resolved{ resolve(program, operand) };
+			if (resolved != operand)
+			{
+				operand = resolved;
+				++program.stats.copiesPropagated;
+				changed = true;
+			}
+		};
+
+		for (IrBlock& block : program.blocks)
+		{
+			if (!block.reachable)
+				continue;
+			for (size_t index : block.values)
+				for (size_t& operand : program.values[index].operands)
+					replace(operand);
+			forEachRoot(block, replace);
+		}
+
+		//a phi whose operands are all one value besides itself is a copy
+		for (IrBlock& block : program.blocks)
+		{
+			for (size_t index : block.values)
+			{
+				IrValue& value = program.values[index];
+				if (value.op != IrOp::phi)
+					continue;
+
+				size_t same{ noValue };
+				bool trivial{ true };
+				for (size_t operand : value.operands)
+				{
+					const size_t resolved{ resolve(program, operand) };
+					if (resolved == index || resolved == same)
+						continue;
+					if (same != noValue)
+						trivial = false;
+					same = resolved;
+				}
+				if (trivial && same != noValue)
+				{
+					value.op = IrOp::copy;
+					value.operands = { same };
+					++program.stats.phisRemoved;
+					changed = true;
+				}
+			}
+		}
+		return changed;
+	}
+
+	bool foldConstants(IrProgram& program)
+	{
+		bool changed{ false };
+		for (IrBlock& block : program.blocks)
+		{
+			for (size_t index : block.values)
+			{
+				IrValue& value = program.values[index];
+				const auto constant = [&](size_t operand) { return program.values[operand].op == IrOp::constant; };
+
+				//arithmetic that would fault stays, so the fault still happens
+				int result;
+				if (arithmetic(value.op) && constant(value.operands[0]) && constant(value.operands[1])
+					&& evaluate(value.op, program.values[value.operands[0]].constant,
+						program.values[value.operands[1]].constant, &result))
+				{
+					value.op = IrOp::constant;
+					value.constant = result;
+					value.operands.clear();
+					++program.stats.constantsFolded;
+					changed = true;
+				}
+
+				//phi of equal constants
+				else if (value.op == IrOp::phi && !value.operands.empty()
+					&& std::all_of(value.operands.begin(), value.operands.end(), [&](size_t operand)
+						{ return constant(operand) && program.values[operand].constant == program.values[value.operands[0]].constant; }))
+				{
+					value.op = IrOp::constant;
+					value.constant = program.values[value.operands[0]].constant;
+					value.operands.clear();
+					++program.stats.constantsFolded;
+					changed = true;
+				}
+			}
+		}
+		return changed;
+	}
+
+	void removePredecessor(IrProgram& program, size_t block, size_t predecessor)
+	{
+		std::vector<size_t>& predecessors = program.blocks[block].predecessors;
+		const auto found = std::find(predecessors.begin(), predecessors.end(), predecessor);
+		if (found == predecessors.end())
+			return;
+
+		const size_t position{ static_cast<size_t>(found - predecessors.begin()) };
+		predecessors.erase(found);
+		for (size_t index : program.blocks[block].values)
+			if (program.values[index].op == IrOp::phi)
+				program.values[index].operands.erase(program.values[index].operands.begin() + static_cast<std::ptrdiff_t>(position));
+	}
+
+	std::vector<size_t> successors(const IrBlock& block)
+	{
+		switch (block.exit)
+		{
+			case IrExit::jump: return { block.taken };
+			case IrExit::halt: return {};
+			default: return block.taken == block.next ? std::vector<size_t>{ block.taken } : std::vector<size_t>{ block.taken, block.next };
+		}
+	}
+
+	bool foldBranches(IrProgram& program)
+	{
+		bool changed{ false };
+		for (size_t i = 0; i < program.blocks.size(); ++i)
+		{
+			IrBlock& block = program.blocks[i];
+			if (!block.reachable || !conditional(block) || program.values[block.condition].op != IrOp::constant)
+				continue;
+
+			const int value{ program.values[block.condition].constant };
+			const bool taken{ block.exit == IrExit::branchNeg ? value < 0 : value == 0 };
+			const size_t other{ taken ? block.next : block.taken };
+			block.taken = taken ? block.taken : block.next;
+			block.exit = IrExit::jump;
+			if (other != block.taken)
+				removePredecessor(program, other, i);
+			++program.stats.branchesFolded;
+			changed = true;
+		}
+
+		//blocks no longer reached from block 0 drop out with their edges
+		std::vector<bool> reached(program.blocks.size(), false);
+		std::vector<size_t> work{ 0 };
+		reached[0] = true;
+		while (!work.empty())
+		{
+			const size_t block{ work.back() };
+			work.pop_back();
+			for (size_t next : successors(program.blocks[block]))
+				if (!reached[next])
+				{
+					reached[next] = true;
+					work.push_back(next);
+				}
+		}
+		for (size_t i = 0; i < program.blocks.size(); ++i)
+		{
+			IrBlock& block = program.blocks[i];
+			if (reached[i] || !block.reachable)
+				continue;
+			for (size_t next : successors(block))
+				removePredecessor(program, next, i);
+			block.reachable = false;
+			block.values.clear();
+			block.finals.clear();
+			block.predecessors.clear();
+			changed = true;
+		}
+		return changed;
+	}
+
+	//dominator sets by the classic iterative data-flow solution
+	std::vector<std::bitset<blockLimit>> dominators(const IrProgram& program)
+	{
+		const size_t count{ program.blocks.size() };
+		std::vector<std::bitset<blockLimit>> dom(count);
+		for (size_t i = 1; i < count; ++i)
+			for (size_t j = 0; j < count; ++j)
+				dom[i].set(j);
+		dom[0].set(0);
+
+		bool changed{ true };
+		while (changed)
+		{
+			changed = false;
+			for (size_t i = 1; i < count; ++i)
+			{
+				if (!program.blocks[i].reachable)
+					continue;
+				std::bitset<blockLimit> meet;
+				meet.set();
+				for (size_t predecessor : program.blocks[i].predecessors)
+					meet &= dom[predecessor];
+				meet.set(i);
+				if (meet != dom[i])
+				{
+					dom[i] = meet;
+					changed = true;
+				}
+			}
+		}
+		return dom;
+	}
+
+	bool eliminateSubexpressions(IrProgram& program)
+	{
+		const std::vector<std::bitset<blockLimit>> dom{ dominators(program) };
+
+		//earlier arithmetic in a dominating position, ordered within blocks
+		std::vector<std::pair<size_t, size_t>> available; //value and position in its block
+		bool changed{ false };
+		for (size_t b = 0; b < program.blocks.size(); ++b)
+		{
+			const IrBlock& block = program.blocks[b];
+			for (size_t position = 0; position < block.values.size(); ++position)
+			{
+				IrValue& value = program.values[block.values[position]];
+				if (!arithmetic(value.op))
+					continue;
+
+				//add and multiply do not care about operand order
+				const bool commutes{ value.op == IrOp::add || value.op == IrOp::multiply };
+				for (const auto& [earlier, earlierPosition] : available)
+				{
+					const IrValue& other = program.values[earlier];
+					const bool same{ other.op == value.op && ((other.operands == value.operands)
+						|| (commutes && other.operands[0] == value.operands[1] && other.operands[1] == value.operands[0])) };
+					const bool dominates{ other.block == b ? earlierPosition < position : dom[b][other.block] };
+					if (same && dominates)
+					{
+						//the earlier one did not fault on the same operands, so this cannot either
+						value.op = IrOp::copy;
+						value.operands = { earlier };
+						++program.stats.subexpressionsEliminated;
+						changed = true;
+						break;
+					}
+				}
+				if (arithmetic(value.op))
+					available.push_back({ block.values[position], position });
+			}
+		}
+		return changed;
+	}
+
+	bool eliminateDead(IrProgram& program)
+	{
+		//side effects and every value a block exit reads stay
+		std::vector<bool> live(program.values.size(), false);
+		std::vector<size_t> work;
+		auto mark = [&](size_t value)
+		{
+			if (!live[value])
+			{
+				live[value] = true;
+				work.push_back(value);
+			}
+		};
+		for (IrBlock& block : program.blocks)
+		{
+			if (!block.reachable)
+				continue;
+			for (size_t index : block.values)
+			{
+				const IrOp op{ program.values[index].op };
+				if (op == IrOp::read || op == IrOp::write || arithmetic(op))
+					mark(index);
+			}
+			forEachRoot(block, mark);
+		}
+		while (!work.empty())
+		{
+			const size_t value{ work.back() };
+			work.pop_back();
+			for (size_t operand : program.values[value].operands)
+				mark(operand);
+		}
+
+		bool changed{ false };
+		for (IrBlock& block : program.blocks)
+		{
+			const size_t before{ block.values.size() };
+			std::erase_if(block.values, [&](size_t index) { return !live[index]; });
+			if (block.values.size() != before)
+			{
+				program.stats.deadRemoved += before - block.values.size();
+				changed = true;
+			}
+		}
+		return changed;
+	}
+
+	const char* opName(IrOp op)
+	{
+		switch (op)
+		{
+			case IrOp::constant: return "const";
+			case IrOp::read: return "read";
+			case IrOp::write: return "write";
+			case IrOp::add: return "add";
+			case IrOp::subtract: return "subtract";
+			case IrOp::multiply: return "multiply";
+			case IrOp::divide: return "divide";
+			case IrOp::phi: return "phi";
+			default: return "copy";
+		}
+	}
+
+	//rerun in the checked interpreter, collecting outputs
+	Termination rerun(const IrProgram& program, const std::vector<int>& inputs, uint64_t budget,
+		MachineState* const statePtr, uint64_t* const executedPtr, std::vector<int>* const outputsPtr)
+	{
+		*statePtr = MachineState{};
+		statePtr->memory = program.image;
+		if (outputsPtr)
+			outputsPtr->clear();
+		OutputObserver observer(outputsPtr);
+		return run(*statePtr, inputs, budget, executedPtr, observer);
+	}
+
+	//where an operand of lowered code lives before addresses are assigned
+	enum class Slot : uint8_t { none, value, constant, cell, temp, label };
+	using Operand = std::pair<Slot, long long>;
+	constexpr Operand noOperand{ Slot::none, 0 };
+	constexpr Operand tempOperand{ Slot::temp, 0 };
+
+	struct LoweredWord
+	{
+		Command command{ Command::halt };
+		Operand operand{ noOperand };
+	};
+
+	//emits blocks in order, falling through where the next block is the
+	//target and dropping loads of what the accumulator already holds
+	class Emitter
+	{
+	public:
+		explicit Emitter(const IrProgram& program) : program{ program }, labels(program.blocks.size(), SIZE_MAX) {}
+
+		void block(size_t b, size_t fallthrough)
+		{
+			const IrBlock& current = program.blocks[b];
+			place(b);
+			for (size_t index : current.values)
+			{
+				const IrValue& value = program.values[index];
+				switch (value.op)
+				{
+					case IrOp::read:
+						emit(Command::read, { Slot::value, index });
+						break;
+					case IrOp::write:
+						emit(Command::write, operandOf(value.operands[0]));
+						break;
+					case IrOp::add:
+					case IrOp::subtract:
+					case IrOp::multiply:
+					case IrOp::divide:
+						emit(Command::load, operandOf(value.operands[0]));
+						emit(value.op == IrOp::add ? Command::add : value.op == IrOp::subtract ? Command::subtract
+							: value.op == IrOp::multiply ? Command::multiply : Command::divide, operandOf(value.operands[1]));
+						emit(Command::store, { Slot::value, index });
+						break;
+					default: //constants sit in the pool, copies and phis need no code here
+						break;
+				}
+			}
+
+			if (conditional(current) && current.taken != current.next)
+			{
+				//an edge into phis gets a stub of copies after the code
+				emit(Command::load, operandOf(current.condition));
+				size_t taken{ current.taken };
+				if (hasPhis(current.taken))
+				{
+					taken = labels.size();
+					labels.push_back(SIZE_MAX);
+					stubs.push_back({ taken, b, current.taken });
+				}
+				emit(current.exit == IrExit::branchNeg ? Command::branchNeg : Command::branchZero, { Slot::label, taken });
+				jump(b, current.next, fallthrough);
+			}
+			else if (current.exit == IrExit::halt)
+			{
+				size_t accumulator{ 0 };
+				for (const auto& [variable, value] : current.finals)
+				{
+					if (variable == accumulatorVariable)
+					{
+						accumulator = value;
+						continue;
+					}
+					emit(Command::load, operandOf(value));
+					emit(Command::store, { Slot::cell, variable });
+				}
+				emit(Command::load, operandOf(accumulator));
+				emit(Command::halt);
+			}
+			else
+				jump(b, current.taken, fallthrough);
+		}
+
+		void finish()
+		{
+			for (const auto& [label, from, to] : stubs)
+			{
+				place(label);
+				jump(from, to, SIZE_MAX);
+			}
+		}
+
+		const std::vector<LoweredWord>& words() const { return code; }
+		size_t labelAddress(long long label) const { return labels[static_cast<size_t>(label)]; }
+
+	private:
+		Operand operandOf(size_t value) const
+		{
+			const size_t resolved{ resolve(program, value) };
+			if (program.values[resolved].op == IrOp::constant)
+				return { Slot::constant, program.values[resolved].constant };
+			return { Slot::value, static_cast<long long>(resolved) };
+		}
+
+		bool hasPhis(size_t block) const
+		{
+			const std::vector<size_t>& values = program.blocks[block].values;
+			return std::any_of(values.begin(), values.end(), [&](size_t index) { return program.values[index].op == IrOp::phi; });
+		}
+
+		void emit(Command command, Operand operand = noOperand)
+		{
+			if (command == Command::load && operand == accumulator)
+				return;
+			code.push_back({ command, operand });
+			if (command == Command::load || command == Command::store)
+				accumulator = operand;
+			else if (command != Command::write && command != Command::branchNeg && command != Command::branchZero
+				&& (command != Command::read || operand == accumulator))
+				accumulator = noOperand;
+		}
+
+		//labels are reached from elsewhere, the accumulator is unknown there
+		void place(size_t label)
+		{
+			labels[label] = code.size();
+			accumulator = noOperand;
+		}
+
+		void jump(size_t from, size_t to, size_t fallthrough)
+		{
+			copies(from, to);
+			if (to != fallthrough)
+				emit(Command::branch, { Slot::label, to });
+		}
+
+		//the phis of to take their operands for the edge from, all at once:
+		//a cell is overwritten only once no pending copy still reads it, and
+		//a cycle of copies goes through the temp cell
+		void copies(size_t from, size_t to)
+		{
+			const IrBlock& target = program.blocks[to];
+			const size_t edge{ static_cast<size_t>(std::find(target.predecessors.begin(), target.predecessors.end(), from)
+				- target.predecessors.begin()) };
+			std::vector<std::pair<Operand, Operand>> pending; //destination and source
+			for (size_t index : target.values)
+			{
+				if (program.values[index].op != IrOp::phi)
+					continue;
+				const Operand destination{ Slot::value, index };
+				const Operand source{ operandOf(program.values[index].operands[edge]) };
+				if (source != destination)
+					pending.push_back({ destination, source });
+			}
+
+			while (!pending.empty())
+			{
+				const auto ready = std::find_if(pending.begin(), pending.end(), [&](const auto& copy)
+					{
+						return std::none_of(pending.begin(), pending.end(), [&](const auto& other) { return other.second == copy.first; });
+					});
+				if (ready == pending.end())
+				{
+					const Operand parked{ pending.front().first };
+					emit(Command::load, parked);
+					emit(Command::store, tempOperand);
+					for (auto& copy : pending)
+						if (copy.second == parked)
+							copy.second = tempOperand;
+					continue;
+				}
+				emit(Command::load, ready->second);
+				emit(Command::store, ready->first);
+				pending.erase(ready);
+			}
+		}
+
+		const IrProgram& program;
+		std::vector<LoweredWord> code;
+		std::vector<size_t> labels; //blocks first, then edge stubs
+		std::vector<std::tuple<size_t, size_t, size_t>> stubs; //label, from and to of each edge stub
+		Operand accumulator{ noOperand }; //what the accumulator is known to hold
+	};
+}
+
+IrProgram lift_to_ssa(const std::array<int, memorySize>& image)
+{
+	IrProgram program;
+	program.image = image;
+
+	const Verification verification{ verify_program(image) };
+	if (!verification.verified || verification.codeWrites.any())
+		return program;
+
+	//block 0 for the initial state, then one per cfg block
+	const ControlFlowGraph cfg{ build_cfg(image) };
+	program.blocks.resize(cfg.blocks.size() + 1);
+	program.blocks[0].taken = cfg.entry + 1;
+
+	std::bitset<memorySize> written;
+	for (size_t i = 0; i < cfg.blocks.size(); ++i)
+	{
+		const BasicBlock& basic = cfg.blocks[i];
+		IrBlock& block = program.blocks[i + 1];
+		block.start = basic.start;
+		block.end = basic.end;
+		for (size_t address = basic.start; address < basic.end; ++address)
+			if (word_info(image[address]).flags & flagWritesMemory)
+				written.set(static_cast<size_t>(image[address] % 100));
+
+		const int last{ image[basic.end - 1] };
+		const size_t operand{ static_cast<size_t>(last % 100) };
+		switch (word_info(last).command)
+		{
+			case Command::branch:
+				block.taken = cfg.blockOf[operand] + 1;
+				break;
+			case Command::branchNeg:
+			case Command::branchZero:
+				block.exit = word_info(last).command == Command::branchNeg ? IrExit::branchNeg : IrExit::branchZero;
+				block.taken = cfg.blockOf[operand] + 1;
+				block.next = cfg.blockOf[basic.end] + 1;
+				break;
+			case Command::halt:
+				block.exit = IrExit::halt;
+				break;
+			default: //runs into the next leader
+				block.taken = cfg.blockOf[basic.end] + 1;
+		}
+	}
+	for (size_t i = 0; i < program.blocks.size(); ++i)
+		for (size_t next : successors(program.blocks[i]))
+			program.blocks[next].predecessors.push_back(i);
+
+	Builder builder(program);
+	builder.fill(0);
+	builder.sealReady();
+	for (size_t i = 1; i < program.blocks.size(); ++i)
+	{
+		IrBlock& block = program.blocks[i];
+		for (size_t address = block.start; address < block.end; ++address)
+		{
+			const int word{ image[address] };
+			const size_t cell{ static_cast<size_t>(word % 100) };
+			const Command command{ word_info(word).command };
+			switch (command)
+			{
+				case Command::read:
+					builder.write(cell, i, builder.add(i, IrOp::read));
+					break;
+				case Command::write:
+					builder.add(i, IrOp::write, { builder.read(cell, i) });
+					break;
+				case Command::load:
+					builder.write(accumulatorVariable, i, builder.read(cell, i));
+					break;
+				case Command::store:
+					builder.write(cell, i, builder.read(accumulatorVariable, i));
+					break;
+				case Command::add:
+				case Command::subtract:
+				case Command::multiply:
+				case Command::divide:
+				{
+					const IrOp op{ command == Command::add ? IrOp::add : command == Command::subtract ? IrOp::subtract
+						: command == Command::multiply ? IrOp::multiply : IrOp::divide };
+					const size_t a{ builder.read(accumulatorVariable, i) };
+					const size_t b{ builder.read(cell, i) };
+					builder.write(accumulatorVariable, i, builder.add(i, op, { a, b }));
+					break;
+				}
+				default:
+					break;
+			}
+		}
+
+		if (conditional(block))
+			block.condition = builder.read(accumulatorVariable, i);
+		else if (block.exit == IrExit::halt)
+		{
+			//halting needs the accumulator and every cell the program can write
+			block.finals.push_back({ accumulatorVariable, builder.read(accumulatorVariable, i) });
+			for (size_t cell = 0; cell < memorySize; ++cell)
+				if (written[cell])
+					block.finals.push_back({ cell, builder.read(cell, i) });
+		}
+		builder.fill(i);
+		builder.sealReady();
+	}
+
+	//phis move in front of the ordered operations
+	for (IrBlock& block : program.blocks)
+		std::stable_partition(block.values.begin(), block.values.end(),
+			[&](size_t index) { return program.values[index].op == IrOp::phi; });
+
+	program.lifted = true;
+	return program;
+}
+
+void optimize_ssa(IrProgram& program)
+{
+	if (!program.lifted)
+		return;
+
+	bool changed{ true };
+	while (changed)
+	{
+		changed = propagateCopies(program);
+		changed |= foldConstants(program);
+		changed |= foldBranches(program);
+		changed |= eliminateSubexpressions(program);
+		changed |= eliminateDead(program);
+	}
+
+	//folding can leave constants between phis, the interpreter wants phis first
+	for (IrBlock& block : program.blocks)
+		std::stable_partition(block.values.begin(), block.values.end(),
+			[&](size_t index) { return program.values[index].op == IrOp::phi; });
+}
+
+Termination run_ssa(const IrProgram& program, const std::vector<int>& inputs, uint64_t budget,
+	MachineState* const statePtr, uint64_t* const executedPtr, std::vector<int>* const outputsPtr)
+{
+	if (!program.lifted)
+		return rerun(program, inputs, budget, statePtr, executedPtr, outputsPtr);
+
+	std::vector<int> registers(program.values.size());
+	std::vector<int> phis;
+	std::vector<int> outputs;
+	uint64_t executed{ 0 };
+	size_t inputIndex{ 0 };
+	size_t block{ 0 };
+	size_t from{ 0 };
+
+	while (true)
+	{
+		const IrBlock& current = program.blocks[block];
+		if (executed + (current.end - current.start) > budget)
+			return rerun(program, inputs, budget, statePtr, executedPtr, outputsPtr);
+
+		//phis read their operands before any of them is assigned
+		size_t position{ 0 };
+		const size_t edge{ static_cast<size_t>(std::find(current.predecessors.begin(), current.predecessors.end(), from)
+			- current.predecessors.begin()) };
+		phis.clear();
+		for (; position < current.values.size() && program.values[current.values[position]].op == IrOp::phi; ++position)
+			phis.push_back(registers[program.values[current.values[position]].operands[edge]]);
+		for (size_t i = 0; i < phis.size(); ++i)
+			registers[current.values[i]] = phis[i];
+
+		for (; position < current.values.size(); ++position)
+		{
+			const size_t index{ current.values[position] };
+			const IrValue& value = program.values[index];
+			switch (value.op)
+			{
+				case IrOp::constant:
+					registers[index] = value.constant;
+					break;
+				case IrOp::read:
+					if (inputIndex >= inputs.size())
+						return rerun(program, inputs, budget, statePtr, executedPtr, outputsPtr);
+					registers[index] = inputs[inputIndex++];
+					break;
+				case IrOp::write:
+					outputs.push_back(registers[value.operands[0]]);
+					break;
+				case IrOp::copy:
+					registers[index] = registers[value.operands[0]];
+					break;
+				default:
+					if (!evaluate(value.op, registers[value.operands[0]], registers[value.operands[1]], &registers[index]))
+						return rerun(program, inputs, budget, statePtr, executedPtr, outputsPtr);
+			}
+		}
+		executed += current.end - current.start;
+
+		from = block;
+		switch (current.exit)
+		{
+			case IrExit::jump:
+				block = current.taken;
+				break;
+			case IrExit::branchNeg:
+				block = registers[current.condition] < 0 ? current.taken : current.next;
+				break;
+			case IrExit::branchZero:
+				block = registers[current.condition] == 0 ? current.taken : current.next;
+				break;
+			default:
+			{
+				//rebuild the machine as the halt instruction leaves it
+				MachineState& state = *statePtr;
+				state.memory = program.image;
+				for (const auto& [variable, value] : current.finals)
+				{
+					if (variable == accumulatorVariable)
+						state.accumulator = registers[value];
+					else
+						state.memory[variable] = registers[value];
+				}
+				state.instructionCounter = current.end - 1;
+				state.instructionRegister = program.image[current.end - 1];
+				state.operationCode = static_cast<size_t>(state.instructionRegister / 100);
+				state.operand = static_cast<size_t>(state.instructionRegister % 100);
+				state.inputIndex = inputIndex;
+				*executedPtr += executed;
+				if (outputsPtr)
+					*outputsPtr = std::move(outputs);
+				return Termination::halted;
+			}
+		}
+	}
+}
+
+LoweredProgram lower_ssa(const IrProgram& program)
+{
+	LoweredProgram lowered;
+	if (!program.lifted)
+		return lowered;
+
+	//block 0 comes first so the image starts there
+	std::vector<size_t> order;
+	for (size_t b = 0; b < program.blocks.size(); ++b)
+		if (program.blocks[b].reachable)
+			order.push_back(b);
+	Emitter emitter(program);
+	for (size_t i = 0; i < order.size(); ++i)
+		emitter.block(order[i], i + 1 < order.size() ? order[i + 1] : SIZE_MAX);
+	emitter.finish();
+	const std::vector<LoweredWord>& words{ emitter.words() };
+
+	//cells the original writes keep their address, code must stay below them
+	std::bitset<memorySize> kept;
+	for (const IrBlock& block : program.blocks)
+		if (block.reachable && block.exit == IrExit::halt)
+			for (const auto& [variable, value] : block.finals)
+				if (variable != accumulatorVariable)
+					kept.set(variable);
+	const size_t length{ words.size() };
+	if (length > memorySize)
+		return lowered;
+	for (size_t cell = 0; cell < length; ++cell)
+		if (kept[cell])
+			return lowered;
+	for (size_t cell = 0; cell < memorySize; ++cell)
+		if (kept[cell])
+			lowered.image[cell] = program.image[cell];
+
+	//values, constants and the temp cell from the top down
+	std::map<Operand, size_t> cells;
+	size_t next{ memorySize };
+	for (const LoweredWord& word : words)
+	{
+		const Slot slot{ word.operand.first };
+		if (slot != Slot::value && slot != Slot::constant && slot != Slot::temp)
+			continue;
+		if (cells.contains(word.operand))
+			continue;
+		do
+		{
+			if (next == length)
+				return lowered;
+			--next;
+		} while (kept[next]);
+		cells.emplace(word.operand, next);
+		if (slot == Slot::constant)
+			lowered.image[next] = static_cast<int>(word.operand.second);
+	}
+
+	for (size_t address = 0; address < length; ++address)
+	{
+		const LoweredWord& word = words[address];
+		size_t operand{ 0 };
+		switch (word.operand.first)
+		{
+			case Slot::none: break;
+			case Slot::cell: operand = static_cast<size_t>(word.operand.second); break;
+			case Slot::label: operand = emitter.labelAddress(word.operand.second); break;
+			default: operand = cells.at(word.operand); break;
+		}
+		lowered.image[address] = static_cast<int>(static_cast<size_t>(word.command) * 100 + operand);
+	}
+	lowered.codeLength = length;
+	lowered.lowered = true;
+	return lowered;
+}
+
+std::string format_ir(const IrProgram& program)
+{
+	std::string text;
+	for (size_t b = 0; b < program.blocks.size(); ++b)
+	{
+		const IrBlock& block = program.blocks[b];
+		if (!block.reachable)
+			continue;
+
+		text += "b" + std::to_string(b);
+		if (b != 0)
+			text += " [" + std::to_string(block.start) + ", " + std::to_string(block.end) + ")";
+		if (!block.predecessors.empty())
+		{
+			text += " <-";
+			for (size_t predecessor : block.predecessors)
+				text += " b" + std::to_string(predecessor);
+		}
+		text += '\n';
+
+		for (size_t index : block.values)
+		{
+			const IrValue& value = program.values[index];
+			text += "  ";
+			if (value.op != IrOp::write)
+				text += "v" + std::to_string(index) + " = ";
+			text += opName(value.op);
+			if (value.op == IrOp::constant)
+				text += " " + std::to_string(value.constant);
+			for (size_t operand : value.operands)
+				text += " v" + std::to_string(operand);
+			text += '\n';
+		}
+
+		switch (block.exit)
+		{
+			case IrExit::jump:
+				text += "  jump b" + std::to_string(block.taken) + "\n";
+				break;
+			case IrExit::branchNeg:
+			case IrExit::branchZero:
+				text += std::string(block.exit == IrExit::branchNeg ? "  branchNeg v" : "  branchZero v")
+					+ std::to_string(block.condition) + " b" + std::to_string(block.taken)
+					+ " b" + std::to_string(block.next) + "\n";
+				break;
+			default:
+				text += "  halt";
+				for (const auto& [variable, value] : block.finals)
+					text += (variable == accumulatorVariable ? std::string(" ac=v") : " [" + std::to_string(variable) + "]=v")
+						+ std::to_string(value);
+				text += '\n';
+		}
+	}
+	return text;
+}
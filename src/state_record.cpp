@@ -0,0 +1,246 @@
+#include "state_record.h"
+
+#include <charconv>
+#include <stdexcept>
+
+namespace
+{
+	//little-endian field writers and readers over a record buffer
+	char* put(char* out, uint64_t value, size_t bytes)
+	{
+		for (size_t i = 0; i < bytes; ++i)
+			*out++ = static_cast<char>(value >> (8 * i));
+		return out;
+	}
+
+	uint64_t get(const char*& in, size_t bytes)
+	{
+		uint64_t value{ 0 };
+		for (size_t i = 0; i < bytes; ++i)
+			value |= static_cast<uint64_t>(static_cast<unsigned char>(*in++)) << (8 * i);
+		return value;
+	}
+
+	char* putInt(char* out, long long value)
+	{
+		return put(out, static_cast<uint32_t>(value), 4);
+	}
+
+	int getInt(const char*& in)
+	{
+		return static_cast<int32_t>(get(in, 4));
+	}
+
+	char* appendNumber(char* out, long long value)
+	{
+		return std::to_chars(out, out + 24, value).ptr;
+	}
+
+	template <size_t N>
+	char* appendText(char* out, const char (&text)[N])
+	{
+		for (size_t i = 0; i + 1 < N; ++i)
+			*out++ = text[i];
+		return out;
+	}
+
+	//opcode and operand are kept as the signed values they came from
+	long long signedRegister(size_t value)
+	{
+		return static_cast<long long>(static_cast<int64_t>(value));
+	}
+
+	//bytes of a record before memory or the change list
+	constexpr size_t registerBytes{ stateRecordSize - 4 * memorySize };
+
+	char* putRegisters(char* p, const StateRecord& record)
+	{
+		const MachineState& state = record.state;
+		p = put(p, record.id, 8);
+		p = put(p, static_cast<uint8_t>(record.termination), 1);
+		p = putInt(p, state.accumulator);
+		p = put(p, state.instructionCounter, 2);
+		p = putInt(p, state.instructionRegister);
+		p = putInt(p, signedRegister(state.operationCode));
+		return putInt(p, signedRegister(state.operand));
+	}
+
+	void getRegisters(const char*& p, StateRecord& record)
+	{
+		MachineState& state = record.state;
+		record.id = get(p, 8);
+		record.termination = static_cast<Termination>(get(p, 1));
+		state.accumulator = getInt(p);
+		state.instructionCounter = get(p, 2);
+		state.instructionRegister = getInt(p);
+		state.operationCode = static_cast<size_t>(static_cast<int64_t>(getInt(p)));
+		state.operand = static_cast<size_t>(static_cast<int64_t>(getInt(p)));
+	}
+
+	//reads exactly size bytes, false at a clean end of stream
+	bool readExactly(std::istream& in, char* buffer, size_t size)
+	{
+		in.read(buffer, static_cast<std::streamsize>(size));
+		if (in.gcount() == 0 && in.eof())
+			return false;
+		if (in.gcount() != static_cast<std::streamsize>(size))
+			throw std::runtime_error("invalid_input");
+		return true;
+	}
+
+	//json fields shared by full and sparse lines, up to the memory part
+	char* appendJsonRegisters(char* p, const StateRecord& record)
+	{
+		const MachineState& state = record.state;
+		p = appendText(p, "{\"id\":");
+		p = appendNumber(p, static_cast<long long>(record.id));
+		p = appendText(p, ",\"termination\":\"");
+		for (const char* name = termination_name(record.termination); *name; ++name)
+			*p++ = *name;
+		p = appendText(p, "\",\"accumulator\":");
+		p = appendNumber(p, state.accumulator);
+		p = appendText(p, ",\"instructionCounter\":");
+		p = appendNumber(p, static_cast<long long>(state.instructionCounter));
+		p = appendText(p, ",\"instructionRegister\":");
+		p = appendNumber(p, state.instructionRegister);
+		p = appendText(p, ",\"operationCode\":");
+		p = appendNumber(p, signedRegister(state.operationCode));
+		p = appendText(p, ",\"operand\":");
+		return appendNumber(p, signedRegister(state.operand));
+	}
+}
+
+void write_state_binary(std::ostream& out, const StateRecord& record)
+{
+	char buffer[stateRecordSize];
+	char* p{ putRegisters(buffer, record) };
+	for (int word : record.state.memory)
+		p = putInt(p, word);
+
+	out.write(buffer, sizeof(buffer));
+}
+
+bool read_state_binary(std::istream& in, StateRecord& record)
+{
+	char buffer[stateRecordSize];
+	if (!readExactly(in, buffer, sizeof(buffer)))
+		return false;
+
+	const char* p{ buffer };
+	getRegisters(p, record);
+	for (int& word : record.state.memory)
+		word = getInt(p);
+
+	return true;
+}
+
+void write_state_json(std::ostream& out, const StateRecord& record)
+{
+	//worst case is every field at full int width, formatted into one line
+	char buffer[512 + 12 * memorySize];
+	char* p{ appendJsonRegisters(buffer, record) };
+	p = appendText(p, ",\"memory\":[");
+	for (size_t i = 0; i < memorySize; ++i)
+	{
+		if (i != 0)
+			*p++ = ',';
+		p = appendNumber(p, record.state.memory[i]);
+	}
+	p = appendText(p, "]}\n");
+
+	out.write(buffer, p - buffer);
+}
+
+std::vector<CellChange> diff_memory(const std::array<int, memorySize>& image,
+	const std::array<int, memorySize>& memory)
+{
+	std::vector<CellChange> changes;
+	for (size_t i = 0; i < memorySize; ++i)
+		if (memory[i] != image[i])
+			changes.push_back({ static_cast<uint8_t>(i), memory[i] });
+	return changes;
+}
+
+void write_diff_binary(std::ostream& out, const StateRecord& record,
+	const std::array<int, memorySize>& image)
+{
+	//largest case is every cell changed
+	char buffer[registerBytes + 1 + 5 * memorySize];
+	char* p{ putRegisters(buffer, record) };
+	char* count{ p++ };
+
+	uint8_t changes{ 0 };
+	for (size_t i = 0; i < memorySize; ++i)
+	{
+		if (record.state.memory[i] == image[i])
+			continue;
+		p = put(p, i, 1);
+		p = putInt(p, record.state.memory[i]);
+		++changes;
+	}
+	*count = static_cast<char>(changes);
+
+	out.write(buffer, p - buffer);
+}
+
+bool read_diff_binary(std::istream& in, const std::array<int, memorySize>& image, StateRecord& record)
+{
+	char buffer[registerBytes + 1 + 5 * memorySize];
+	if (!readExactly(in, buffer, registerBytes + 1))
+		return false;
+
+	const char* p{ buffer };
+	getRegisters(p, record);
+	const size_t changes{ get(p, 1) };
+	if (changes > memorySize || (changes > 0 && !readExactly(in, buffer, 5 * changes)))
+		throw std::runtime_error("invalid_input");
+
+	//start from the image and apply each change
+	record.state.memory = image;
+	p = buffer;
+	for (size_t i = 0; i < changes; ++i)
+	{
+		const size_t address{ get(p, 1) };
+		if (address >= memorySize)
+			throw std::runtime_error("invalid_input");
+		record.state.memory[address] = getInt(p);
+	}
+
+	return true;
+}
+
+void write_diff_json(std::ostream& out, const StateRecord& record,
+	const std::array<int, memorySize>& image)
+{
+	char buffer[512 + 18 * memorySize];
+	char* p{ appendJsonRegisters(buffer, record) };
+	p = appendText(p, ",\"changes\":[");
+	bool first{ true };
+	for (size_t i = 0; i < memorySize; ++i)
+	{
+		if (record.state.memory[i] == image[i])
+			continue;
+		if (!first)
+			*p++ = ',';
+		first = false;
+		*p++ = '[';
+		p = appendNumber(p, static_cast<long long>(i));
+		*p++ = ',';
+		p = appendNumber(p, record.state.memory[i]);
+		*p++ = ']';
+	}
+	p = appendText(p, "]}\n");
+
+	out.write(buffer, p - buffer);
+}
+
+const char* termination_name(Termination termination)
+{
+	switch (termination)
+	{
+		case Termination::halted: return "halted";
+		case Termination::faulted: return "faulted";
+		case Termination::budgetExceeded: return "budgetExceeded";
+		default: return "unknown";
+	}
+}
@@ -0,0 +1,420 @@
+#include "tiered.h"
+#include "container.h"
+#include "interpreter.h"
+#include "isa.h"
+
+namespace
+{
+	DecodedWord decode(int word)
+	{
+		return { word_info(word).command, static_cast<size_t>(word % 100), word };
+	}
+
+	void decodeAll(const std::array<int, memorySize>& memory, std::array<DecodedWord, memorySize>& code)
+	{
+		for (size_t address = 0; address < memorySize; ++address)
+			code[address] = decode(memory[address]);
+	}
+
+	//the interpreter's observer plus the counters of the profile
+	struct ProfilingObserver : OutputObserver
+	{
+		ProfilingObserver(std::vector<int>* const outputsPtr, TierProfile& profile)
+			: OutputObserver{ outputsPtr }, profile{ profile } {}
+
+		void on_branch(size_t from, size_t to, bool taken)
+		{
+			if (taken && to <= from)
+			{
+				++profile.backwardBranches;
+				++profile.loopCounts[to];
+			}
+		}
+
+		TierProfile& profile;
+	};
+
+	//the interpreter's observer plus the address of every instruction
+	struct RecordingObserver : OutputObserver
+	{
+		using OutputObserver::OutputObserver;
+
+		void on_fetch(size_t address, int word)
+		{
+			OutputObserver::on_fetch(address, word);
+			path.push_back(address);
+		}
+
+		std::vector<size_t> path;
+	};
+}
+
+TieredEngine::TieredEngine(TierThresholds thresholds) : thresholds{ thresholds }
+{
+}
+
+const TierProfile* TieredEngine::profile(const std::array<int, memorySize>& image) const
+{
+	const auto found{ profiles.find(program_hash(image)) };
+	return found != profiles.end() && found->second.image == image ? &found->second : nullptr;
+}
+
+TierProfile& TieredEngine::profileFor(const std::array<int, memorySize>& image)
+{
+	//a colliding image starts over rather than inherit another's profile
+	TierProfile& profile{ profiles[program_hash(image)] };
+	if (profile.runs == 0 || profile.image != image)
+	{
+		profile = TierProfile{};
+		profile.image = image;
+		profile.traceAt.fill(SIZE_MAX);
+	}
+	return profile;
+}
+
+bool TieredEngine::interpret(TierProfile& profile, MachineState& state, const std::vector<int>& inputs, uint64_t budget,
+	uint64_t* const donePtr, std::vector<int>* const outputsPtr, Termination* const terminationPtr)
+{
+	ProfilingObserver observer(outputsPtr, profile);
+	Command command;
+	while (*donePtr < budget)
+	{
+		if (!execute_instruction(state.memory, &state.accumulator,
+			&state.instructionCounter, &state.instructionRegister,
+			&state.operationCode, &state.operand,
+			inputs, &state.inputIndex, &command, observer))
+		{
+			*terminationPtr = Termination::faulted;
+			return true;
+		}
+		++*donePtr;
+		if (command == Command::halt)
+		{
+			*terminationPtr = Termination::halted;
+			return true;
+		}
+		if (profile.backwardBranches >= thresholds.decoded)
+			return false;
+	}
+	*terminationPtr = Termination::budgetExceeded;
+	return true;
+}
+
+bool TieredEngine::recordTrace(TierProfile& profile, MachineState& state, const std::vector<int>& inputs, uint64_t budget,
+	uint64_t* const donePtr, std::vector<int>* const outputsPtr, Termination* const terminationPtr)
+{
+	//one iteration in the interpreter, from the header until it comes back
+	const size_t header{ state.instructionCounter };
+	profile.traceTried.set(header);
+	RecordingObserver observer(outputsPtr);
+	Command command;
+	while (*donePtr < budget)
+	{
+		if (!execute_instruction(state.memory, &state.accumulator,
+			&state.instructionCounter, &state.instructionRegister,
+			&state.operationCode, &state.operand,
+			inputs, &state.inputIndex, &command, observer))
+		{
+			*terminationPtr = Termination::faulted;
+			return true;
+		}
+		++*donePtr;
+		if (command == Command::halt)
+		{
+			*terminationPtr = Termination::halted;
+			return true;
+		}
+		if (state.instructionCounter == header)
+		{
+			Trace trace{ compile_trace(header, observer.path, state.memory) };
+			if (trace.compiled)
+			{
+				for (const size_t address : trace.path)
+					profile.traced.set(address);
+				profile.traceAt[header] = profile.traces.size();
+				profile.traces.push_back(std::move(trace));
+			}
+			return false;
+		}
+		if (observer.path.size() >= traceLimit)
+			return false;
+	}
+	*terminationPtr = Termination::budgetExceeded;
+	return true;
+}
+
+template <bool optimized>
+bool TieredEngine::runDecoded(TierProfile& profile, std::array<DecodedWord, memorySize>& code, MachineState& state,
+	const std::vector<int>& inputs, uint64_t budget, uint64_t* const donePtr,
+	std::vector<int>* const outputsPtr, Termination* const terminationPtr)
+{
+	//registers live in locals and are written back whenever the state is
+	//handed to other code. memory is written in place.
+	std::array<int, memorySize>& memory = state.memory;
+	int accumulator{ state.accumulator };
+	size_t ic{ state.instructionCounter };
+	size_t inputIndex{ state.inputIndex };
+	int word{ state.instructionRegister };
+	uint64_t done{ *donePtr };
+
+	auto writeBack = [&]
+	{
+		state.accumulator = accumulator;
+		state.instructionCounter = ic;
+		state.inputIndex = inputIndex;
+		state.instructionRegister = word;
+		state.operationCode = static_cast<size_t>(word / 100);
+		state.operand = static_cast<size_t>(word % 100);
+		*donePtr = done;
+	};
+	auto reload = [&]
+	{
+		accumulator = state.accumulator;
+		ic = state.instructionCounter;
+		inputIndex = state.inputIndex;
+		word = state.instructionRegister;
+		done = *donePtr;
+	};
+	//traces whose words this run still holds
+	std::vector<bool> live;
+	auto refreshLive = [&]
+	{
+		live.assign(profile.traces.size(), true);
+		for (size_t index = 0; index < profile.traces.size(); ++index)
+		{
+			const Trace& trace{ profile.traces[index] };
+			for (size_t step = 0; step < trace.path.size(); ++step)
+				if (memory[trace.path[step]] != trace.words[step])
+					live[index] = false;
+		}
+	};
+	if constexpr (optimized)
+		refreshLive();
+	auto overwrite = [&](size_t address, int value)
+	{
+		memory[address] = value;
+		code[address] = decode(value);
+		if constexpr (optimized)
+		{
+			if (profile.traced[address])
+				refreshLive();
+		}
+	};
+
+	//a taken branch is where loops are counted, promoted, summarized and
+	//traced. in the decoded tier true when the run leaves for the next
+	//tier, in the optimized tier true when the run has ended.
+	auto branchTo = [&](size_t target)
+	{
+		const bool backward{ target <= ic };
+		if (backward)
+		{
+			++profile.backwardBranches;
+			++profile.loopCounts[target];
+		}
+		ic = target;
+		if constexpr (optimized)
+		{
+			if (profile.summaries.loopAt[ic] != SIZE_MAX)
+			{
+				const LoopSummary& loop{ profile.summaries.loops[profile.summaries.loopAt[ic]] };
+				writeBack();
+				*donePtr += skip_iterations(loop, state, budget - done) * loop.length;
+				reload();
+				return false;
+			}
+			const size_t index{ profile.traceAt[ic] };
+			if (index != SIZE_MAX && live[index])
+			{
+				const Trace& trace{ profile.traces[index] };
+				done += run_trace(trace, memory, &accumulator, &ic, &word, budget - done, outputsPtr);
+				for (const size_t address : trace.stores)
+					overwrite(address, memory[address]);
+				return false;
+			}
+			if (backward && !profile.traceTried[ic] && profile.loopCounts[ic] >= thresholds.trace)
+			{
+				writeBack();
+				if (recordTrace(profile, state, inputs, budget, donePtr, outputsPtr, terminationPtr))
+					return true;
+				decodeAll(memory, code);
+				refreshLive();
+				reload();
+			}
+			return false;
+		}
+		else
+			return profile.backwardBranches >= thresholds.optimized;
+	};
+
+	//faults and running off memory go through the checked interpreter
+	//once, which leaves the registers exactly as it would. true when that
+	//instruction ended the run.
+	auto checked = [&]
+	{
+		writeBack();
+		OutputObserver observer(outputsPtr);
+		Command command;
+		if (!execute_instruction(state.memory, &state.accumulator,
+			&state.instructionCounter, &state.instructionRegister,
+			&state.operationCode, &state.operand,
+			inputs, &state.inputIndex, &command, observer))
+		{
+			*terminationPtr = Termination::faulted;
+			return true;
+		}
+		++*donePtr;
+		if (command == Command::halt)
+		{
+			*terminationPtr = Termination::halted;
+			return true;
+		}
+		decodeAll(state.memory, code);
+		reload();
+		return false;
+	};
+	//false when the result is out of range, the accumulator is unchanged
+	auto arithmetic = [&](long long result)
+	{
+		if (result < minWord || result > maxWord)
+			return false;
+		accumulator = static_cast<int>(result);
+		return true;
+	};
+
+	while (done < budget)
+	{
+		if (ic >= memorySize)
+		{
+			if (checked())
+				return true;
+			continue;
+		}
+
+		const DecodedWord& instruction{ code[ic] };
+		const size_t operand{ instruction.operand };
+		bool faults{ false };
+		switch (instruction.command)
+		{
+			case Command::read:
+				if (inputIndex >= inputs.size())
+				{
+					faults = true;
+					break;
+				}
+				overwrite(operand, inputs[inputIndex++]);
+				break;
+			case Command::write:
+				if (outputsPtr)
+					outputsPtr->push_back(memory[operand]);
+				break;
+			case Command::load:
+				accumulator = memory[operand];
+				break;
+			case Command::store:
+				overwrite(operand, accumulator);
+				break;
+			case Command::add:
+				faults = !arithmetic(static_cast<long long>(accumulator) + memory[operand]);
+				break;
+			case Command::subtract:
+				faults = !arithmetic(static_cast<long long>(accumulator) - memory[operand]);
+				break;
+			case Command::multiply:
+				faults = !arithmetic(static_cast<long long>(accumulator) * memory[operand]);
+				break;
+			case Command::divide:
+				faults = memory[operand] == 0 || !arithmetic(static_cast<long long>(accumulator) / memory[operand]);
+				break;
+			case Command::branch:
+			case Command::branchNeg:
+			case Command::branchZero:
+				word = instruction.word;
+				++done;
+				if (instruction.command != Command::branch
+					&& !(instruction.command == Command::branchNeg ? accumulator < 0 : accumulator == 0))
+				{
+					++ic;
+					continue;
+				}
+				if (branchTo(operand))
+				{
+					if constexpr (optimized)
+						return true;
+					writeBack();
+					return false;
+				}
+				continue;
+			default:
+				word = instruction.word;
+				++done;
+				writeBack();
+				*terminationPtr = Termination::halted;
+				return true;
+		}
+
+		if (faults)
+		{
+			if (checked())
+				return true;
+			continue;
+		}
+		word = instruction.word;
+		++done;
+		++ic;
+	}
+
+	writeBack();
+	*terminationPtr = Termination::budgetExceeded;
+	return true;
+}
+
+Termination TieredEngine::run(const std::array<int, memorySize>& image, const std::vector<int>& inputs, uint64_t budget,
+	MachineState* const statePtr, uint64_t* const executedPtr, std::vector<int>* const outputsPtr)
+{
+	TierProfile& profile{ profileFor(image) };
+	++profile.runs;
+
+	MachineState& state{ *statePtr };
+	state = MachineState{};
+	state.memory = image;
+	std::array<DecodedWord, memorySize> code{ profile.decoded };
+
+	uint64_t done{ 0 };
+	Termination termination{ Termination::budgetExceeded };
+	while (true)
+	{
+		//promotion prepares the tier once for the program, and the code of
+		//this run from its memory as it is now
+		if (profile.tier == Tier::interpreted && profile.backwardBranches >= thresholds.decoded)
+		{
+			profile.tier = Tier::decoded;
+			decodeAll(profile.image, profile.decoded);
+			decodeAll(state.memory, code);
+		}
+		if (profile.tier == Tier::decoded && profile.backwardBranches >= thresholds.optimized)
+		{
+			profile.tier = Tier::optimized;
+			profile.summaries = summarize_loops(profile.image);
+		}
+
+		bool finished;
+		switch (profile.tier)
+		{
+			case Tier::interpreted:
+				finished = interpret(profile, state, inputs, budget, &done, outputsPtr, &termination);
+				break;
+			case Tier::decoded:
+				finished = runDecoded<false>(profile, code, state, inputs, budget, &done, outputsPtr, &termination);
+				break;
+			default:
+				finished = runDecoded<true>(profile, code, state, inputs, budget, &done, outputsPtr, &termination);
+				break;
+		}
+		if (finished)
+			break;
+	}
+
+	*executedPtr += done;
+	return termination;
+}
@@ -0,0 +1,177 @@
+#include "trace.h"
+
+#include <chrono>
+#include <stdexcept>
+
+namespace
+{
+	char* put32(char* out, int value)
+	{
+		const uint32_t bits{ static_cast<uint32_t>(value) };
+		for (int i = 0; i < 4; ++i)
+			*out++ = static_cast<char>(bits >> (8 * i));
+		return out;
+	}
+
+	int get32(const unsigned char*& in)
+	{
+		uint32_t bits{ 0 };
+		for (int i = 0; i < 4; ++i)
+			bits |= static_cast<uint32_t>(*in++) << (8 * i);
+		return static_cast<int32_t>(bits);
+	}
+
+	//entries written per batch by the background writer
+	constexpr size_t flushBatch{ 4096 };
+	constexpr std::chrono::microseconds idleWait{ 500 };
+}
+
+TraceRing::TraceRing(size_t capacity)
+{
+	size_t size{ 1 };
+	while (size < capacity)
+		size <<= 1;
+	entries = std::make_unique<TraceEntry[]>(size);
+	mask = size - 1;
+}
+
+bool TraceRing::push(const TraceEntry& entry)
+{
+	const size_t position{ head.load(std::memory_order_relaxed) };
+	if (position - tail.load(std::memory_order_acquire) > mask)
+		return false;
+
+	//publish the slot only after it is filled
+	entries[position & mask] = entry;
+	head.store(position + 1, std::memory_order_release);
+	return true;
+}
+
+size_t TraceRing::pop(TraceEntry* out, size_t max)
+{
+	const size_t position{ tail.load(std::memory_order_relaxed) };
+	const size_t available{ head.load(std::memory_order_acquire) - position };
+	const size_t count{ available < max ? available : max };
+
+	for (size_t i = 0; i < count; ++i)
+		out[i] = entries[(position + i) & mask];
+	tail.store(position + count, std::memory_order_release);
+	return count;
+}
+
+TraceRecorder::TraceRecorder(const std::string& filename, size_t capacity)
+	: ring{ capacity }, file{ filename, std::ios::binary | std::ios::trunc }
+{
+	if (!file)
+		throw std::runtime_error("invalid_input");
+	writer = std::thread(&TraceRecorder::flushLoop, this);
+}
+
+TraceRecorder::~TraceRecorder()
+{
+	stopping.store(true, std::memory_order_release);
+	writer.join();
+}
+
+void TraceRecorder::record(const TraceEntry& entry)
+{
+	//lossless: the machine waits rather than drop an entry
+	while (!ring.push(entry))
+		std::this_thread::yield();
+}
+
+void TraceRecorder::flushLoop()
+{
+	std::unique_ptr<TraceEntry[]> batch{ std::make_unique<TraceEntry[]>(flushBatch) };
+	std::unique_ptr<char[]> bytes{ std::make_unique<char[]>(flushBatch * traceEntrySize) };
+
+	while (true)
+	{
+		//check stopping before draining so the last entries are not lost
+		const bool last{ stopping.load(std::memory_order_acquire) };
+		const size_t count{ ring.pop(batch.get(), flushBatch) };
+
+		//encode the batch and write it in one call
+		char* out{ bytes.get() };
+		for (size_t i = 0; i < count; ++i)
+		{
+			const TraceEntry& entry = batch[i];
+			*out++ = static_cast<char>(entry.instructionCounter);
+			*out++ = static_cast<char>(entry.writeAddress);
+			*out++ = static_cast<char>(entry.faulted ? 1 : 0);
+			out = put32(out, entry.instructionRegister);
+			out = put32(out, entry.accumulatorBefore);
+			out = put32(out, entry.accumulatorAfter);
+			out = put32(out, entry.writeValue);
+		}
+		file.write(bytes.get(), out - bytes.get());
+
+		if (count == 0)
+		{
+			if (last)
+				break;
+			std::this_thread::sleep_for(idleWait); //nothing queued, back off
+		}
+	}
+
+	file.flush();
+}
+
+void execute_traced(std::array<int, memorySize>& memory, int* const acPtr,
+	size_t* const icPtr, int* const irPtr,
+	size_t* const opCodePtr, size_t* const opPtr,
+	const std::vector<int>& inputs, TraceRecorder& recorder)
+{
+	size_t inputIndex{ 0 }; //Tracks input
+	Command command;
+
+	do
+	{
+		TraceEntry entry;
+		entry.instructionCounter = static_cast<uint8_t>(*icPtr);
+		entry.accumulatorBefore = *acPtr;
+
+		try
+		{
+			command = step(memory, acPtr, icPtr, irPtr, opCodePtr, opPtr, inputs, &inputIndex);
+		}
+		catch (const std::runtime_error&)
+		{
+			//record the faulting instruction, then let the fault through
+			entry.instructionRegister = *irPtr;
+			entry.accumulatorAfter = *acPtr;
+			entry.faulted = true;
+			recorder.record(entry);
+			throw;
+		}
+
+		entry.instructionRegister = *irPtr;
+		entry.accumulatorAfter = *acPtr;
+		if (command == Command::read || command == Command::store)
+		{
+			entry.writeAddress = static_cast<uint8_t>(*opPtr);
+			entry.writeValue = memory[*opPtr];
+		}
+		recorder.record(entry);
+	} while (command != Command::halt);
+}
+
+bool read_trace_entry(std::istream& in, TraceEntry& entry)
+{
+	unsigned char bytes[traceEntrySize];
+	in.read(reinterpret_cast<char*>(bytes), sizeof(bytes));
+	if (in.gcount() == 0 && in.eof())
+		return false;
+	if (in.gcount() != static_cast<std::streamsize>(sizeof(bytes)))
+		throw std::runtime_error("invalid_input");
+
+	const unsigned char* p{ bytes + 3 };
+	entry.instructionCounter = bytes[0];
+	entry.writeAddress = bytes[1];
+	entry.faulted = bytes[2] != 0;
+	entry.instructionRegister = get32(p);
+	entry.accumulatorBefore = get32(p);
+	entry.accumulatorAfter = get32(p);
+	entry.writeValue = get32(p);
+	return true;
+}
@@ -0,0 +1,231 @@
+#include "trace_compiler.h"
+#include "isa.h"
+
+#include <algorithm>
+
+namespace
+{
+	bool isArithmetic(Command command)
+	{
+		return command == Command::add || command == Command::subtract
+			|| command == Command::multiply || command == Command::divide;
+	}
+
+	//false where the interpreter would fault
+	bool arithmetic(Command command, int left, int right, int* const resultPtr)
+	{
+		long long result;
+		switch (command)
+		{
+			case Command::add: result = static_cast<long long>(left) + right; break;
+			case Command::subtract: result = static_cast<long long>(left) - right; break;
+			case Command::multiply: result = static_cast<long long>(left) * right; break;
+			default:
+				if (right == 0)
+					return false;
+				result = static_cast<long long>(left) / right;
+				break;
+		}
+		if (result < minWord || result > maxWord)
+			return false;
+		*resultPtr = static_cast<int>(result);
+		return true;
+	}
+
+	//an instruction of the path that becomes part of an operation
+	struct Step
+	{
+		size_t index{ 0 }; //position in the path
+		Command command{ Command::halt };
+		size_t operand{ 0 };
+	};
+}
+
+Trace compile_trace(size_t header, const std::vector<size_t>& path, const std::array<int, memorySize>& memory)
+{
+	Trace trace;
+	trace.header = header;
+	trace.path = path;
+	if (path.empty() || path.size() > traceLimit || path.front() != header)
+		return trace;
+
+	//the path must be the one the words take, and close on the header
+	std::vector<Step> steps;
+	for (size_t index = 0; index < path.size(); ++index)
+	{
+		const size_t address{ path[index] };
+		const size_t next{ index + 1 < path.size() ? path[index + 1] : header };
+		const int word{ memory[address] };
+		const Command command{ word_info(word).command };
+		const size_t operand{ static_cast<size_t>(word % 100) };
+		trace.words.push_back(word);
+		switch (command)
+		{
+			case Command::load:
+			case Command::store:
+			case Command::write:
+			case Command::add:
+			case Command::subtract:
+			case Command::multiply:
+			case Command::divide:
+				if (next != address + 1)
+					return trace;
+				steps.push_back({ index, command, operand });
+				break;
+			case Command::branch:
+				if (next != operand)
+					return trace;
+				break;
+			case Command::branchNeg:
+			case Command::branchZero:
+				if (next != operand && next != address + 1)
+					return trace;
+				//a branch to the next word goes there either way
+				if (operand != address + 1)
+					steps.push_back({ index, command, operand });
+				break;
+			default:
+				return trace;
+		}
+		if (command == Command::store && std::find(path.begin(), path.end(), operand) != path.end())
+			return trace;
+		if (command == Command::store)
+			trace.stores.push_back(operand);
+	}
+	trace.closing = trace.words.back();
+
+	//load, arithmetic and store fuse in the order they appear
+	auto is = [&](size_t step, bool (*test)(Command))
+	{
+		return step < steps.size() && test(steps[step].command);
+	};
+	auto isLoad = [](Command command) { return command == Command::load; };
+	auto isStore = [](Command command) { return command == Command::store; };
+	for (size_t step = 0; step < steps.size();)
+	{
+		const Step& at{ steps[step] };
+		TraceOp op;
+		op.address = path[at.index];
+		op.offset = static_cast<uint32_t>(at.index);
+		op.before = at.index > 0 ? trace.words[at.index - 1] : trace.closing;
+		op.first = at.operand;
+		size_t fused{ 1 };
+		if (is(step, isLoad) && is(step + 1, isArithmetic) && is(step + 2, isStore))
+		{
+			op.kind = TraceOpKind::loadArithmeticStore;
+			op.command = steps[step + 1].command;
+			op.second = steps[step + 1].operand;
+			op.third = steps[step + 2].operand;
+			fused = 3;
+		}
+		else if (is(step, isLoad) && is(step + 1, isArithmetic))
+		{
+			op.kind = TraceOpKind::loadArithmetic;
+			op.command = steps[step + 1].command;
+			op.second = steps[step + 1].operand;
+			fused = 2;
+		}
+		else if (is(step, isArithmetic) && is(step + 1, isStore))
+		{
+			op.kind = TraceOpKind::arithmeticStore;
+			op.command = at.command;
+			op.second = steps[step + 1].operand;
+			fused = 2;
+		}
+		else
+		{
+			op.command = at.command;
+			switch (at.command)
+			{
+				case Command::load: op.kind = TraceOpKind::load; break;
+				case Command::store: op.kind = TraceOpKind::store; break;
+				case Command::write: op.kind = TraceOpKind::write; break;
+				case Command::branchNeg:
+				case Command::branchZero:
+				{
+					op.kind = TraceOpKind::guard;
+					const size_t next{ at.index + 1 < path.size() ? path[at.index + 1] : header };
+					op.taken = next == at.operand;
+					break;
+				}
+				default: op.kind = TraceOpKind::arithmetic; break;
+			}
+		}
+		trace.ops.push_back(op);
+		step += fused;
+	}
+	trace.compiled = true;
+	return trace;
+}
+
+uint64_t run_trace(const Trace& trace, std::array<int, memorySize>& memory, int* const accumulatorPtr,
+	size_t* const icPtr, int* const wordPtr, uint64_t budget, std::vector<int>* const outputsPtr)
+{
+	const uint64_t length{ trace.path.size() };
+	int accumulator{ *accumulatorPtr };
+	uint64_t executed{ 0 };
+
+	//back to the instruction the operation starts with
+	auto leave = [&](const TraceOp& op)
+	{
+		*accumulatorPtr = accumulator;
+		*icPtr = op.address;
+		if (executed + op.offset > 0)
+			*wordPtr = op.before;
+		return executed + op.offset;
+	};
+
+	while (budget - executed >= length)
+	{
+		for (const TraceOp& op : trace.ops)
+		{
+			int result;
+			switch (op.kind)
+			{
+				case TraceOpKind::load:
+					accumulator = memory[op.first];
+					break;
+				case TraceOpKind::store:
+					memory[op.first] = accumulator;
+					break;
+				case TraceOpKind::write:
+					if (outputsPtr)
+						outputsPtr->push_back(memory[op.first]);
+					break;
+				case TraceOpKind::arithmetic:
+					if (!arithmetic(op.command, accumulator, memory[op.first], &result))
+						return leave(op);
+					accumulator = result;
+					break;
+				case TraceOpKind::loadArithmetic:
+					if (!arithmetic(op.command, memory[op.first], memory[op.second], &result))
+						return leave(op);
+					accumulator = result;
+					break;
+				case TraceOpKind::arithmeticStore:
+					if (!arithmetic(op.command, accumulator, memory[op.first], &result))
+						return leave(op);
+					accumulator = result;
+					memory[op.second] = result;
+					break;
+				case TraceOpKind::loadArithmeticStore:
+					if (!arithmetic(op.command, memory[op.first], memory[op.second], &result))
+						return leave(op);
+					accumulator = result;
+					memory[op.third] = result;
+					break;
+				case TraceOpKind::guard:
+					if ((op.command == Command::branchNeg ? accumulator < 0 : accumulator == 0) != op.taken)
+						return leave(op);
+					break;
+			}
+		}
+		executed += length;
+	}
+
+	*accumulatorPtr = accumulator;
+	*icPtr = trace.header;
+	if (executed > 0)
+		*wordPtr = trace.closing;
+	return executed;
+}
@@ -0,0 +1,158 @@
+#include "verifier.h"
+#include "cfg.h"
+#include "interpreter.h"
+#include "isa.h"
+
+namespace
+{
+	//the rest of a run in the checked interpreter
+	Termination checked(MachineState& state, const std::vector<int>& inputs,
+		uint64_t budget, uint64_t* const executedPtr)
+	{
+		NullObserver observer;
+		return run(state, inputs, budget, executedPtr, observer);
+	}
+}
+
+Verification verify_program(const std::array<int, memorySize>& memory)
+{
+	Verification verification;
+	const ControlFlowGraph cfg{ build_cfg(memory) };
+
+	for (const BasicBlock& block : cfg.blocks)
+	{
+		for (size_t address = block.start; address < block.end; ++address)
+		{
+			verification.code.set(address);
+			const int word{ memory[address] };
+			if (word < 0)
+				verification.issues.push_back({ address, VerifyError::negativeWord });
+			else if (!defined_opcode(static_cast<size_t>(word / 100)))
+				verification.issues.push_back({ address, VerifyError::invalidOpcode });
+		}
+		if (block.exitsMemory)
+			verification.issues.push_back({ block.end - 1, VerifyError::fallsOffMemory });
+	}
+
+	//read and store have fixed targets, so every write to code is known now
+	for (size_t address = 0; address < memorySize; ++address)
+	{
+		if (verification.code[address] && (word_info(memory[address]).flags & flagWritesMemory)
+			&& verification.code[memory[address] % 100])
+			verification.codeWrites.set(address);
+	}
+
+	verification.verified = verification.issues.empty();
+	return verification;
+}
+
+Termination run_unchecked(MachineState& state, const std::vector<int>& inputs,
+	uint64_t budget, uint64_t* const executedPtr, const Verification& verification)
+{
+	if (!verification.verified || state.instructionCounter >= memorySize
+		|| !verification.code[state.instructionCounter])
+		return checked(state, inputs, budget, executedPtr);
+
+	//registers live in locals and are written back on every exit. every
+	//address reached from here is verified code and code cannot change
+	//without a flagged write, so fetch and decode need no checks.
+	std::array<int, memorySize>& memory = state.memory;
+	int accumulator{ state.accumulator };
+	size_t ic{ state.instructionCounter };
+	size_t inputIndex{ state.inputIndex };
+	int word{ state.instructionRegister };
+	Termination termination{ Termination::budgetExceeded };
+	uint64_t i{ 0 };
+
+	for (; i < budget; ++i)
+	{
+		if (verification.codeWrites[ic])
+			break;
+
+		word = memory[ic];
+		const size_t operand{ static_cast<size_t>(word % 100) };
+		long long result;
+		switch (static_cast<Command>(word / 100))
+		{
+			case Command::read:
+				if (inputIndex >= inputs.size())
+				{
+					termination = Termination::faulted;
+					break;
+				}
+				memory[operand] = inputs[inputIndex++];
+				++ic;
+				continue;
+			case Command::write:
+				++ic;
+				continue;
+			case Command::load:
+				accumulator = memory[operand];
+				++ic;
+				continue;
+			case Command::store:
+				memory[operand] = accumulator;
+				++ic;
+				continue;
+			case Command::add:
+				result = static_cast<long long>(accumulator) + memory[operand];
+				break;
+			case Command::subtract:
+				result = static_cast<long long>(accumulator) - memory[operand];
+				break;
+			case Command::divide:
+				if (memory[operand] == 0)
+				{
+					termination = Termination::faulted;
+					break;
+				}
+				result = static_cast<long long>(accumulator) / memory[operand];
+				break;
+			case Command::multiply:
+				result = static_cast<long long>(accumulator) * memory[operand];
+				break;
+			case Command::branch:
+				ic = operand;
+				continue;
+			case Command::branchNeg:
+				ic = accumulator < 0 ? operand : ic + 1;
+				continue;
+			case Command::branchZero:
+				ic = accumulator == 0 ? operand : ic + 1;
+				continue;
+			default: //halt, the verifier admits no other opcode
+				++i;
+				termination = Termination::halted;
+				break;
+		}
+
+		//a fault or halt above ends the run
+		if (termination != Termination::budgetExceeded)
+			break;
+
+		//arithmetic result checked before it reaches the accumulator
+		if (result < minWord || result > maxWord)
+		{
+			termination = Termination::faulted;
+			break;
+		}
+		accumulator = static_cast<int>(result);
+		++ic;
+	}
+
+	*executedPtr += i;
+	state.accumulator = accumulator;
+	state.instructionCounter = ic;
+	state.inputIndex = inputIndex;
+	if (i != 0 || termination == Termination::faulted)
+	{
+		state.instructionRegister = word;
+		state.operationCode = static_cast<size_t>(word / 100);
+		state.operand = static_cast<size_t>(word % 100);
+	}
+
+	//a write to code continues checked, the image no longer matches the proof
+	if (termination == Termination::budgetExceeded && i < budget)
+		return checked(state, inputs, budget - i, executedPtr);
+	return termination;
+}
@@ -0,0 +1,226 @@
+//coverage-guided fuzzing of the loader and interpreter.
+//
+//built with -DCOMPUTRON_LIBFUZZER and -fsanitize=fuzzer this is a plain
+//libFuzzer target. otherwise main() runs its own in-process loop:
+//  computron_fuzz [runs] [seed]
+//
+//input layout: byte 0 picks the mode. even runs a binary image, then a
+//word count byte, that many i16 words and the inputs: i16 folded into
+//the word range when byte 0 is a multiple of 4, otherwise raw i32 as the
+//daemon, replay and tiered engine can receive them. odd feeds the rest
+//as program text to load_from_buffer() and runs it with fixed inputs.
+//nothing on this path touches files or throws.
+
+#include "cfg.h"
+#include "interpreter.h"
+
+#include <bitset>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+
+namespace
+{
+	constexpr uint64_t fuzzBudget{ 1000 }; //instructions per run
+
+	//block-to-block edges, keyed by the start addresses of both blocks
+	using EdgeMap = std::bitset<memorySize * memorySize>;
+
+	//records an edge every time execution enters a block of the cfg
+	struct EdgeObserver : NullObserver
+	{
+		EdgeObserver(const ControlFlowGraph& cfg, EdgeMap& edges) : cfg{ cfg }, edges{ edges } {}
+
+		void on_fetch(size_t address, int)
+		{
+			//code stored at run time has no block, its address stands in
+			const size_t block{ cfg.blockOf[address] };
+			const size_t start{ block == noBlock ? address : cfg.blocks[block].start };
+			if (start == address)
+			{
+				edges.set(previous * memorySize + start);
+				previous = start;
+			}
+		}
+
+		const ControlFlowGraph& cfg;
+		EdgeMap& edges;
+		size_t previous{ 0 };
+	};
+
+	int16_t get16(const uint8_t* data)
+	{
+		return static_cast<int16_t>(data[0] | data[1] << 8);
+	}
+
+	int32_t get32(const uint8_t* data)
+	{
+		return static_cast<int32_t>(data[0] | data[1] << 8 | data[2] << 16 | static_cast<uint32_t>(data[3]) << 24);
+	}
+
+	//decodes one input, runs it and checks the machine invariants
+	void fuzz_one(const uint8_t* data, size_t size, EdgeMap& edges)
+	{
+		if (size == 0)
+			return;
+
+		MachineState state;
+		std::vector<int> inputs;
+		const bool raw{ data[0] % 4 == 2 };
+		if (data[0] % 2 == 0)
+		{
+			//binary image, words folded into the valid range
+			const size_t words{ size > 1 ? data[1] % (memorySize + 1) : 0 };
+			size_t position{ 2 };
+			for (size_t i = 0; i < words && position + 1 < size; ++i, position += 2)
+				state.memory[i] = get16(data + position) % (maxWord + 1);
+			if (raw)
+				for (; position + 3 < size; position += 4)
+					inputs.push_back(get32(data + position));
+			else
+				for (; position + 1 < size; position += 2)
+					inputs.push_back(get16(data + position) % (maxWord + 1));
+		}
+		else
+		{
+			std::string_view text{ reinterpret_cast<const char*>(data + 1), size - 1 };
+			size_t wordCount;
+			if (!load_from_buffer(state.memory, text, &wordCount))
+				return;
+			inputs = { 1, -1, 0, maxWord, minWord };
+		}
+
+		const ControlFlowGraph cfg{ build_cfg(state.memory) };
+		EdgeObserver observer(cfg, edges);
+		uint64_t executed{ 0 };
+		const Termination termination{ run(state, inputs, fuzzBudget, &executed, observer) };
+
+		//a run that did not fault must leave a sane machine. raw inputs may
+		//be loaded into the accumulator as they are.
+		if (termination != Termination::faulted)
+		{
+			if (state.instructionCounter >= memorySize || (!raw && !validWord(state.accumulator))
+				|| state.inputIndex > inputs.size())
+				std::abort();
+		}
+		if (executed > fuzzBudget)
+			std::abort();
+	}
+}
+
+#ifdef COMPUTRON_LIBFUZZER
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	static EdgeMap edges;
+	fuzz_one(data, size, edges);
+	return 0;
+}
+
+#else
+
+namespace
+{
+	//random edits in the style of libFuzzer's default mutators
+	void mutate(std::vector<uint8_t>& input, const std::vector<std::vector<uint8_t>>& corpus, std::mt19937& random)
+	{
+		const int edits{ 1 + static_cast<int>(random() % 4) };
+		for (int i = 0; i < edits; ++i)
+		{
+			const size_t at{ input.empty() ? 0 : random() % input.size() };
+			switch (random() % 5)
+			{
+				case 0: //flip a bit
+					if (!input.empty())
+						input[at] ^= static_cast<uint8_t>(1 << random() % 8);
+					break;
+				case 1: //random byte
+					if (!input.empty())
+						input[at] = static_cast<uint8_t>(random());
+					break;
+				case 2: //insert a byte
+					if (input.size() < 512)
+						input.insert(input.begin() + static_cast<std::ptrdiff_t>(at), static_cast<uint8_t>(random()));
+					break;
+				case 3: //erase a byte
+					if (input.size() > 1)
+						input.erase(input.begin() + static_cast<std::ptrdiff_t>(at));
+					break;
+				default: //splice the tail of another corpus entry
+				{
+					const std::vector<uint8_t>& other = corpus[random() % corpus.size()];
+					if (!other.empty())
+					{
+						const size_t from{ random() % other.size() };
+						input.resize(at);
+						input.insert(input.end(), other.begin() + static_cast<std::ptrdiff_t>(from), other.end());
+						if (input.size() > 512)
+							input.resize(512);
+					}
+					break;
+				}
+			}
+		}
+	}
+
+	void put(std::vector<uint8_t>& bytes, int value, int size)
+	{
+		for (int i = 0; i < size; ++i)
+			bytes.push_back(static_cast<uint8_t>((static_cast<uint32_t>(value) >> (8 * i)) & 0xFF));
+	}
+
+	//binary image seed holding the given words, raw seeds carry i32 inputs
+	std::vector<uint8_t> seed(std::initializer_list<int> words, std::initializer_list<int> inputs, bool raw = false)
+	{
+		std::vector<uint8_t> bytes{ static_cast<uint8_t>(raw ? 2 : 0), static_cast<uint8_t>(words.size()) };
+		for (int word : words)
+			put(bytes, word, 2);
+		for (int input : inputs)
+			put(bytes, input, raw ? 4 : 2);
+		return bytes;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint64_t runs{ argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000 };
+	std::mt19937 random(argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10)) : 1);
+
+	//seeds: the sample sum program, a countdown loop, a division of raw
+	//inputs and a text program
+	std::vector<std::vector<uint8_t>> corpus{
+		seed({ 1007, 1008, 2007, 3008, 2109, 1109, 4300 }, { 4, 5 }),
+		seed({ 2010, 4206, 2010, 3111, 2110, 4000, 4300, 0, 0, 0, 5, 1 }, {}),
+		seed({ 1007, 1008, 2007, 3208, 2109, 1109, 4300 }, { std::numeric_limits<int>::min(), -1 }, true),
+	};
+	const char text[]{ "\x01+1005\n+2005\n+3305\n+2105\n+4300\n-99999\n" };
+	corpus.emplace_back(text, text + sizeof(text) - 1);
+
+	EdgeMap edges;
+	for (const std::vector<uint8_t>& input : corpus)
+		fuzz_one(input.data(), input.size(), edges);
+
+	//keep every mutant that reaches a new edge
+	const auto start{ std::chrono::steady_clock::now() };
+	std::vector<uint8_t> input;
+	for (uint64_t i = 0; i < runs; ++i)
+	{
+		input = corpus[random() % corpus.size()];
+		mutate(input, corpus, random);
+
+		const size_t before{ edges.count() };
+		fuzz_one(input.data(), input.size(), edges);
+		if (edges.count() != before)
+			corpus.push_back(input);
+	}
+
+	const double seconds{ std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() };
+	std::printf("%llu runs in %.2fs (%.0f/s), %zu edges, corpus %zu\n",
+		static_cast<unsigned long long>(runs), seconds, seconds > 0 ? runs / seconds : 0.0,
+		edges.count(), corpus.size());
+}
+
+#endif
@@ -0,0 +1,140 @@
+#include "catch2/catch.hpp"
+#include "assembler.h"
+#include "replay.h"
+
+//loads assembled words the way load_from_file would see them
+static std::array<int, memorySize> image(const AssembledProgram& program)
+{
+    REQUIRE(program.errors.empty());
+    std::array<int, memorySize> memory{ 0 };
+    const std::string text = program_text(program.words);
+    std::string_view view{ text };
+    size_t wordCount{ 0 };
+    REQUIRE(load_from_buffer(memory, view, &wordCount));
+    REQUIRE(wordCount == program.words.size());
+    return memory;
+}
+
+//sums inputs until a zero is read, with every inefficiency the passes remove
+static const char* const sumSource =
+    "; sum inputs until zero\n"
+    "start:  read x\n"
+    "        load x\n"
+    "        branchZero out      ; jumps to a jump\n"
+    "        load sum\n"
+    "        add x\n"
+    "        store sum\n"
+    "        load sum            ; reload of the stored cell\n"
+    "        branch next\n"
+    "next:   branch start\n"
+    "        write sum           ; never reached\n"
+    "out:    branch done\n"
+    "done:   write sum\n"
+    "        halt\n"
+    "x:      data 0\n"
+    "sum:    data 0\n"
+    "unused: data 42\n";
+
+TEST_CASE("Assembles as written without optimization", "[assemble]") {
+    const AssembledProgram program = assemble(
+        "loop: load n ; comment\n"
+        "  branchNeg 05\n"
+        "  subtract one\n"
+        "  store n\n"
+        "  branch loop\n"
+        "  halt\n"
+        "n: data 3\n"
+        "one: data +1\n"
+        "neg: data -7\n", false);
+    REQUIRE_FALSE(program.optimized);
+    REQUIRE(program.words == std::vector<int>{ 2006, 4105, 3107, 2106, 4000, 4300, 3, 1, -7 });
+    REQUIRE(program_text(program.words) == "+2006\n+4105\n+3107\n+2106\n+4000\n+4300\n+0003\n+0001\n-0007\n-99999\n");
+}
+
+TEST_CASE("Assembly errors name their line", "[assemble]") {
+    const AssembledProgram program = assemble(
+        "a: load b\n"
+        "   jump a\n"
+        "   store\n"
+        "a: halt 5\n"
+        "b: data 10000\n"
+        "   add missing\n"
+        "   load 100\n"
+        "end:\n");
+    REQUIRE(program.words.empty());
+    REQUIRE(program.errors.size() == 8);
+    REQUIRE(program.errors[0].line == 2);
+    REQUIRE(program.errors[0].message == "unknown mnemonic 'jump'");
+    REQUIRE(program.errors[1].message == "store needs one operand");
+    REQUIRE(program.errors[2].message == "duplicate label 'a'");
+    REQUIRE(program.errors[3].message == "halt takes no operand");
+    REQUIRE(program.errors[4].line == 5);
+    REQUIRE(program.errors[5].message == "operand must be a label or an address from 0 to 99");
+    REQUIRE(program.errors[6].message == "label 'end' has no statement");
+    REQUIRE(program.errors[7].message == "undefined label 'missing'");
+
+    std::string big;
+    for (int i = 0; i < 101; ++i)
+        big += "data 1\n";
+    REQUIRE(assemble(big).errors.size() == 1);
+}
+
+TEST_CASE("Optimization passes keep behavior", "[assemble]") {
+    const AssembledProgram plain = assemble(sumSource, false);
+    const AssembledProgram optimized = assemble(sumSource);
+    REQUIRE(optimized.optimized);
+    REQUIRE(optimized.stats.jumpsThreaded == 2);
+    REQUIRE(optimized.stats.branchesDropped == 1); //out: branch done
+    REQUIRE(optimized.stats.unreachableDropped == 2);
+    REQUIRE(optimized.stats.loadsDropped == 1);
+    REQUIRE(optimized.stats.cellsPacked == 1);
+
+    //start: read x / load x / branchZero done / load sum / add x / store sum /
+    //branch start / done: write sum / halt / x / sum
+    REQUIRE(optimized.words == std::vector<int>{ 1009, 2009, 4207, 2010, 3009, 2110, 4000, 1110, 4300, 0, 0 });
+    REQUIRE(plain.words.size() == 16);
+
+    for (const std::vector<int>& inputs : { std::vector<int>{ 4, 5, 0 }, std::vector<int>{ 0 }, std::vector<int>{ 9999, 1, 0 } })
+    {
+        const RunLog before = record_run(image(plain), inputs);
+        const RunLog after = record_run(image(optimized), inputs);
+        REQUIRE(before.termination == after.termination);
+        REQUIRE(before.outputs == after.outputs);
+        REQUIRE(after.executed < before.executed);
+    }
+}
+
+TEST_CASE("Constants are shared and branches to the next instruction dropped", "[assemble]") {
+    const AssembledProgram program = assemble(
+        "  load a\n"
+        "  add b\n"
+        "  branchNeg skip\n"
+        "skip: store out\n"
+        "  write out\n"
+        "  halt\n"
+        "a: data 5\n"
+        "b: data 5\n"
+        "out: data 0\n");
+    REQUIRE(program.optimized);
+    REQUIRE(program.stats.branchesDropped == 1);
+    REQUIRE(program.stats.cellsPacked == 1);
+    REQUIRE(program.words == std::vector<int>{ 2005, 3005, 2106, 1106, 4300, 5, 0 });
+}
+
+TEST_CASE("Programs using addresses keep their layout", "[assemble]") {
+    //the store rewrites code, so nothing may move
+    const AssembledProgram program = assemble(
+        "  load h\n"
+        "  store 03\n"
+        "  branch 03\n"
+        "  write h\n"
+        "h: data 4300\n");
+    REQUIRE_FALSE(program.optimized);
+    REQUIRE(program.words == std::vector<int>{ 2004, 2103, 4003, 1104, 4300 });
+
+    //a loop of jumps is not threaded, it only shrinks to a single spin
+    const AssembledProgram spin = assemble("a: branch b\nb: branch a\n");
+    REQUIRE(spin.optimized);
+    REQUIRE(spin.stats.jumpsThreaded == 0);
+    REQUIRE(spin.words == std::vector<int>{ 4000 });
+}
@@ -0,0 +1,91 @@
+#include "catch2/catch.hpp"
+#include "batch_loader.h"
+
+#include <filesystem>
+#include <fstream>
+
+TEST_CASE("Load program from buffer", "[load_from_buffer]") {
+    std::array<int, memorySize> memory{ 0 };
+    size_t wordCount{ 0 };
+
+    //two programs back to back
+    std::string_view text{ "+1007\n  -0005\r\n-99999\n4300\n" };
+    REQUIRE(load_from_buffer(memory, text, &wordCount));
+    REQUIRE(wordCount == 2);
+    REQUIRE(memory[0] == 1007);
+    REQUIRE(memory[1] == -5);
+    REQUIRE(text == "4300\n");
+    REQUIRE(load_from_buffer(memory, text, &wordCount));
+    REQUIRE(wordCount == 1);
+    REQUIRE(text.empty());
+
+    //invalid words, junk lines and oversized programs fail
+    std::string_view big{ "+10000\n" };
+    REQUIRE_FALSE(load_from_buffer(memory, big, &wordCount));
+    std::string_view junk{ "abc\n" };
+    REQUIRE_FALSE(load_from_buffer(memory, junk, &wordCount));
+    std::string oversized;
+    for (size_t i = 0; i <= memorySize; i++)
+        oversized += "1\n";
+    std::string_view over{ oversized };
+    REQUIRE_FALSE(load_from_buffer(memory, over, &wordCount));
+    REQUIRE(wordCount == memorySize);
+}
+
+TEST_CASE("Batch load directories, globs and multi-program files", "[load_batch]") {
+    //directory with two good programs and one bad one
+    const std::filesystem::path dir{ "batch_dir" };
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directory(dir);
+    std::ofstream(dir / "a.txt") << "+1007\n+4300\n-99999\n";
+    std::ofstream(dir / "b.txt") << "+2001\n";
+    std::ofstream(dir / "c.sml") << "+99999\n";
+    std::ofstream longFile(dir / "d.sml");
+    for (size_t i = 0; i <= memorySize; i++)
+        longFile << "+1\n";
+    longFile.close();
+
+    ProgramBatch batch = load_batch(dir.string(), 2);
+    REQUIRE(batch.index.size() == 2);
+    REQUIRE(batch.arena.size() == 2 * memorySize);
+    REQUIRE(batch.index[0].name == "a.txt");
+    REQUIRE(batch.index[0].wordCount == 2);
+    REQUIRE(batch.index[1].name == "b.txt");
+    REQUIRE(batch.index[1].offset == memorySize);
+
+    //bad files reported without aborting the batch
+    REQUIRE(batch.errors.size() == 2);
+    REQUIRE(batch.errors[0].name == "c.sml");
+    REQUIRE(batch.errors[0].message == "invalid word");
+    REQUIRE(batch.errors[1].name == "d.sml");
+    REQUIRE(batch.errors[1].message == "program too long");
+
+    //images come back zero filled
+    std::array<int, memorySize> memory;
+    batch.image(1, memory);
+    REQUIRE(memory[0] == 2001);
+    REQUIRE(memory[1] == 0);
+
+    //glob only picks the matching files
+    batch = load_batch((dir / "*.sml").string(), 1);
+    REQUIRE(batch.index.empty());
+    REQUIRE(batch.errors.size() == 2);
+
+    //one file holding many programs
+    std::ofstream multi("multi.txt");
+    for (int i = 0; i < 500; i++)
+        multi << "+" << 1000 + i % 100 << "\n+4300\n-99999\n";
+    multi << "+1234\n";
+    multi.close();
+
+    batch = load_batch("multi.txt");
+    REQUIRE(batch.index.size() == 501);
+    REQUIRE(batch.errors.empty());
+    REQUIRE(batch.index[499].name == "multi.txt#499");
+    REQUIRE(batch.arena[499 * memorySize] == 1099);
+    REQUIRE(batch.arena[500 * memorySize] == 1234);
+
+    //missing path
+    REQUIRE_THROWS_AS(load_batch("notreal.txt"), std::runtime_error);
+    REQUIRE_THROWS_AS(batch.image(600, memory), std::runtime_error);
+}
@@ -0,0 +1,73 @@
+#include "catch2/catch.hpp"
+#include "cfg.h"
+
+TEST_CASE("Basic blocks and loops", "[build_cfg]") {
+    //sum n + (n-1) + ... + 1 into mem[21]
+    std::array<int, memorySize> memory{ 0 };
+    memory[0] = 1020; //read n
+    memory[1] = 2020; //loop: load n
+    memory[2] = 4210; //branch zero to halt
+    memory[3] = 2021; //sum += n
+    memory[4] = 3020;
+    memory[5] = 2121;
+    memory[6] = 2020; //n -= 1
+    memory[7] = 3122;
+    memory[8] = 2120;
+    memory[9] = 4001; //back to loop
+    memory[10] = 4300;
+    memory[22] = 1;
+
+    const ControlFlowGraph cfg = build_cfg(memory);
+
+    //four blocks split at branches and branch targets
+    REQUIRE(cfg.blocks.size() == 4);
+    REQUIRE(cfg.blocks[0].start == 0);
+    REQUIRE(cfg.blocks[0].end == 1);
+    REQUIRE(cfg.blocks[1].start == 1);
+    REQUIRE(cfg.blocks[1].end == 3);
+    REQUIRE(cfg.blocks[2].end == 10);
+    REQUIRE(cfg.blocks[3].start == 10);
+    REQUIRE(cfg.entry == 0);
+
+    //conditional branch lists the taken target first
+    REQUIRE(cfg.blocks[1].successors == std::vector<size_t>{ 3, 2 });
+    REQUIRE(cfg.blocks[1].predecessors == std::vector<size_t>{ 0, 2 });
+    REQUIRE(cfg.blocks[3].successors.empty());
+
+    //one loop closed by the back branch
+    REQUIRE(cfg.backEdges.size() == 1);
+    REQUIRE(cfg.backEdges[0] == std::make_pair<size_t, size_t>(2, 1));
+    REQUIRE(cfg.blocks[1].loopHeader);
+    REQUIRE(cfg.loops.size() == 1);
+    REQUIRE(cfg.loops[0].blocks == std::vector<size_t>{ 1, 2 });
+
+    //data cells are not code
+    REQUIRE(cfg.blockOf[22] == noBlock);
+    REQUIRE(cfg.blockOf[5] == 2);
+
+    //dot export names every block and dashes the back edge
+    const std::string dot = cfg_to_dot(cfg, memory);
+    REQUIRE(dot.find("b2 -> b1 [style=dashed];") != std::string::npos);
+    REQUIRE(dot.find("02: branchZero 10") != std::string::npos);
+}
+
+TEST_CASE("Control flow edge cases", "[build_cfg]") {
+    //code running off the end of memory
+    std::array<int, memorySize> memory{ 0 };
+    memory[0] = 4098;
+    memory[98] = 2000;
+    memory[99] = 2000;
+    ControlFlowGraph cfg = build_cfg(memory);
+    REQUIRE(cfg.blocks.size() == 2);
+    REQUIRE(cfg.blocks[1].exitsMemory);
+
+    //self loop and negative words, which halt
+    memory.fill(0);
+    memory[0] = 4100;
+    memory[1] = -1234;
+    cfg = build_cfg(memory);
+    REQUIRE(cfg.blocks.size() == 2);
+    REQUIRE(cfg.blocks[0].loopHeader);
+    REQUIRE(cfg.blocks[1].successors.empty());
+    REQUIRE(successors_of(-1234, 1).empty());
+}
@@ -0,0 +1,159 @@
+#include "catch2/catch.hpp"
+#include "computrond.h"
+
+#include <filesystem>
+#include <limits>
+#include <thread>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+TEST_CASE("Daemon runs preloaded programs", "[handle_request]") {
+    std::vector<std::array<int, memorySize>> images(1);
+    images[0].fill(0);
+    load_from_file(images[0], "p1.txt");
+    const std::vector<Precomputed> programs = preload_programs(images);
+
+    //run program 0 with two inputs
+    const RunResponse response = decode_response(handle_request(programs, encode_run_request(0, { 4, 5 })));
+    REQUIRE(response.status == RunStatus::halted);
+    REQUIRE(response.state.memory[9] == 9);
+    REQUIRE(response.state.accumulator == 9);
+    REQUIRE(response.state.instructionCounter == 6);
+    REQUIRE(response.state.instructionRegister == 4300);
+    REQUIRE(response.state.operationCode == 43);
+
+    //write output is returned
+    REQUIRE(response.outputs == std::vector<int>{ 9 });
+
+    //missing input faults
+    REQUIRE(decode_response(handle_request(programs, encode_run_request(0, { 4 }))).status == RunStatus::faulted);
+
+    //unknown program and garbage requests
+    REQUIRE(decode_response(handle_request(programs, encode_run_request(7, {}))).status == RunStatus::badRequest);
+    REQUIRE(decode_response(handle_request(programs, "")).status == RunStatus::badRequest);
+    REQUIRE(decode_response(handle_request(programs, "\x02\x05")).status == RunStatus::badRequest);
+}
+
+TEST_CASE("Daemon runs sent images", "[handle_request]") {
+    //infinite loop stops at the budget
+    std::array<int, memorySize> spin{ 0 };
+    spin[0] = 4000;
+    REQUIRE(run_program(spin, {}, 1000).status == RunStatus::budgetExceeded);
+
+    //inputs outside the word range are refused
+    std::array<int, memorySize> memory{ 0 };
+    memory[0] = 1010;
+    memory[1] = 4300;
+    REQUIRE(decode_response(handle_request({}, encode_image_request(memory, { -99999 }))).status == RunStatus::badRequest);
+    const RunResponse response = decode_response(handle_request({}, encode_image_request(memory, { -9999 })));
+    REQUIRE(response.status == RunStatus::halted);
+    REQUIRE(response.state.memory[10] == -9999);
+
+    //a write loop stops at the output limit and its response still decodes
+    std::array<int, memorySize> chatty{ 0 };
+    chatty[0] = 1150;
+    chatty[1] = 4000;
+    const RunResponse limited = decode_response(handle_request({}, encode_image_request(chatty, {})));
+    REQUIRE(limited.status == RunStatus::outputExceeded);
+    REQUIRE(limited.outputs.size() == daemonOutputLimit);
+    REQUIRE(limited.state.instructionCounter == 1);
+    const std::vector<Precomputed> programs = preload_programs({ chatty });
+    const RunResponse preloaded = decode_response(handle_request(programs, encode_run_request(0, {})));
+    REQUIRE(preloaded.status == RunStatus::outputExceeded);
+    REQUIRE(preloaded.state == limited.state);
+    REQUIRE(preloaded.outputs == limited.outputs);
+
+    //without a limit the run ends at the budget, too long to encode
+    const RunResponse unlimited = run_program(chatty, {});
+    REQUIRE(unlimited.status == RunStatus::budgetExceeded);
+    REQUIRE_THROWS_AS(encode_response(unlimited), std::runtime_error);
+}
+
+TEST_CASE("Daemon serves framed requests on a socket", "[serve_connection]") {
+    std::vector<std::array<int, memorySize>> images(1);
+    images[0].fill(0);
+    load_from_file(images[0], "p1.txt");
+    const std::vector<Precomputed> programs = preload_programs(images);
+
+    int fds[2];
+    REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    std::thread server([&] { serve_connection(fds[1], programs); });
+
+    //several requests over one connection
+    std::string frame;
+    for (int i = 0; i < 10; i++)
+    {
+        REQUIRE(write_frame(fds[0], encode_run_request(0, { i, i })));
+        REQUIRE(read_frame(fds[0], frame));
+        REQUIRE(decode_response(frame).state.memory[9] == 2 * i);
+    }
+
+    //INT_MIN / -1 is refused as input and faults from the image, and the
+    //daemon still answers afterwards
+    std::array<int, memorySize> divide{ 0 };
+    divide[0] = 1010;
+    divide[1] = 1011;
+    divide[2] = 2010;
+    divide[3] = 3211;
+    divide[4] = 4300;
+    REQUIRE(write_frame(fds[0], encode_image_request(divide, { std::numeric_limits<int>::min(), -1 })));
+    REQUIRE(read_frame(fds[0], frame));
+    REQUIRE(decode_response(frame).status == RunStatus::badRequest);
+    divide[0] = 2010;
+    divide[1] = 3211;
+    divide[10] = std::numeric_limits<int>::min();
+    divide[11] = -1;
+    REQUIRE(write_frame(fds[0], encode_image_request(divide, {})));
+    REQUIRE(read_frame(fds[0], frame));
+    REQUIRE(decode_response(frame).status == RunStatus::faulted);
+    REQUIRE(write_frame(fds[0], encode_run_request(0, { 2, 3 })));
+    REQUIRE(read_frame(fds[0], frame));
+    REQUIRE(decode_response(frame).state.memory[9] == 5);
+
+    //closing the client ends the server loop
+    ::close(fds[0]);
+    server.join();
+    ::close(fds[1]);
+}
+
+TEST_CASE("Daemon client talks to a listening daemon", "[DaemonClient]") {
+    //the listener never returns, it outlives the test on its own thread
+    static std::vector<Precomputed> programs;
+    std::array<int, memorySize> image{ 0 };
+    load_from_file(image, "p1.txt");
+    programs = preload_programs({ image });
+    const std::string socketPath{ (std::filesystem::temp_directory_path()
+        / ("computrond_test_" + std::to_string(::getpid()) + ".sock")).string() };
+    std::thread([socketPath] { serve(socketPath, programs); }).detach();
+
+    //wait for the daemon to listen
+    std::unique_ptr<DaemonClient> client;
+    for (int attempt = 0; !client && attempt < 1000; attempt++)
+    {
+        try
+        {
+            client = std::make_unique<DaemonClient>(socketPath);
+        }
+        catch (const std::runtime_error&)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    REQUIRE(client);
+
+    const RunResponse preloaded = client->run(0, { 4, 5 });
+    REQUIRE(preloaded.status == RunStatus::halted);
+    REQUIRE(preloaded.outputs == std::vector<int>{ 9 });
+
+    //a second connection is served alongside the first
+    DaemonClient second(socketPath);
+    image[1] = 1150;
+    image[2] = 4001;
+    const RunResponse limited = second.run(image, { 4 });
+    REQUIRE(limited.status == RunStatus::outputExceeded);
+    REQUIRE(limited.outputs.size() == daemonOutputLimit);
+    REQUIRE(client->run(0, { 1, 2 }).state.memory[9] == 3);
+
+    std::filesystem::remove(socketPath);
+}
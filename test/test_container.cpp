@@ -0,0 +1,89 @@
+#include "catch2/catch.hpp"
+#include "container.h"
+
+#include <filesystem>
+#include <fstream>
+
+//empty scratch directory for the files a test writes
+static std::filesystem::path scratchDirectory(const std::string& name)
+{
+    const std::filesystem::path dir{ std::filesystem::temp_directory_path() / name };
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directory(dir);
+    return dir;
+}
+
+TEST_CASE("Container round trip", "[ProgramContainer]") {
+    const std::filesystem::path dir{ scratchDirectory("computron_container_round_trip") };
+    const std::string source{ (dir / "container_src.txt").string() };
+    const std::string path{ (dir / "programs.ctr").string() };
+
+    //build a batch of programs from one multi-program file
+    std::ofstream multi(source);
+    for (int i = 0; i < 300; i++)
+        multi << "+" << 2000 + i % 100 << "\n+4300\n-99999\n";
+    multi.close();
+    const ProgramBatch batch = load_batch(source);
+    write_container(path, batch);
+
+    {
+        ProgramContainer container(path);
+        REQUIRE(container.size() == 300);
+
+        //every program found by name with identical image and metadata
+        std::array<int, memorySize> expected, actual;
+        for (size_t i = 0; i < batch.index.size(); i++)
+        {
+            batch.image(i, expected);
+            const size_t found = container.find(batch.index[i].name);
+            REQUIRE(found == i);
+            container.image(found, actual);
+            REQUIRE(actual == expected);
+            REQUIRE(container.wordCount(i) == 2);
+            REQUIRE(container.hash(i) == program_hash(expected));
+        }
+        REQUIRE(container.words(5)[0] == 2005);
+        REQUIRE(container.name(7) == "container_src.txt#7");
+
+        //lookups that miss
+        REQUIRE(container.find("nothing") == container.size());
+        REQUIRE_THROWS_AS(container.words(300), std::runtime_error);
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("Container rejects bad files", "[ProgramContainer]") {
+    const std::filesystem::path dir{ scratchDirectory("computron_container_bad_files") };
+    REQUIRE_THROWS_AS(ProgramContainer((dir / "notreal.ctr").string()), std::runtime_error);
+
+    const std::string garbage{ (dir / "garbage.ctr").string() };
+    std::ofstream(garbage) << "this is not a container file at all, not even close";
+    REQUIRE_THROWS_AS(ProgramContainer(garbage), std::runtime_error);
+
+    //a name offset that wraps around the end of the file
+    const std::string source{ (dir / "corrupt_src.txt").string() };
+    const std::string path{ (dir / "corrupt.ctr").string() };
+    std::ofstream(source) << "+1007\n+4300\n-99999\n";
+    write_container(path, load_batch(source));
+    std::fstream corrupt(path, std::ios::binary | std::ios::in | std::ios::out);
+    uint64_t namesOffset{ 0 };
+    corrupt.seekg(16);
+    corrupt.read(reinterpret_cast<char*>(&namesOffset), sizeof(namesOffset));
+    const uint64_t wrapping{ UINT64_MAX - 2 };
+    corrupt.seekp(static_cast<std::streamoff>(namesOffset - 24)); //the only index entry
+    corrupt.write(reinterpret_cast<const char*>(&wrapping), sizeof(wrapping));
+    corrupt.close();
+    REQUIRE_THROWS_AS(ProgramContainer(path), std::runtime_error);
+
+    //empty batches still make a valid container
+    const std::string emptyPath{ (dir / "empty.ctr").string() };
+    write_container(emptyPath, ProgramBatch{});
+    {
+        ProgramContainer empty(emptyPath);
+        REQUIRE(empty.size() == 0);
+        REQUIRE(empty.find("x") == 0);
+    }
+
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,84 @@
+#include "catch2/catch.hpp"
+#include "coverage.h"
+
+#include <thread>
+
+//reads x, stores 1 in mem[30] when x is negative, 2 when zero, else 3
+static std::array<int, memorySize> signProgram()
+{
+    std::array<int, memorySize> memory{ 0 };
+    memory[0] = 1020; //read x
+    memory[1] = 2020; //load x
+    memory[2] = 4108; //negative
+    memory[3] = 4210; //zero
+    memory[4] = 2023; //positive: 3
+    memory[5] = 2130;
+    memory[6] = 4300;
+    memory[8] = 2021; //negative: 1
+    memory[9] = 4011;
+    memory[10] = 2022; //zero: 2
+    memory[11] = 2130;
+    memory[12] = 4300;
+    memory[21] = 1;
+    memory[22] = 2;
+    memory[23] = 3;
+    return memory;
+}
+
+TEST_CASE("Coverage of single runs", "[CoverageObserver]") {
+    const std::array<int, memorySize> image = signProgram();
+
+    //positive input only walks the fall through path
+    CoverageMap map;
+    CoverageObserver observer(map);
+    MachineState state;
+    state.memory = image;
+    uint64_t executed{ 0 };
+    REQUIRE(run(state, { 5 }, 100, &executed, observer) == Termination::halted);
+    REQUIRE(state.memory[30] == 3);
+
+    CoverageReport report = report_coverage(image, map);
+    REQUIRE(report.instructions == 12);
+    REQUIRE(report.covered == 7);
+    REQUIRE(report.uncovered == std::vector<size_t>{ 8, 9, 10, 11, 12 });
+    REQUIRE(report.directions == 4);
+    REQUIRE(report.directionsCovered == 2);
+    REQUIRE(report.neverTaken == std::vector<size_t>{ 2, 3 });
+    REQUIRE(report.alwaysTaken.empty());
+    REQUIRE(format_coverage(report).find("uncovered: 08 09 10 11 12\n") != std::string::npos);
+}
+
+TEST_CASE("Coverage merged across a batch", "[BatchCoverage]") {
+    const std::array<int, memorySize> image = signProgram();
+    BatchCoverage batch(2);
+
+    //many threads sweep inputs, each job merging its own map
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&, t] {
+            for (int input = -20 + t; input <= 20; input += 4)
+            {
+                CoverageMap map;
+                CoverageObserver observer(map);
+                MachineState state;
+                state.memory = image;
+                uint64_t executed{ 0 };
+                run(state, { input }, 100, &executed, observer);
+                batch.merge(0, map);
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    //every path was exercised somewhere in the sweep
+    const CoverageReport report = report_coverage(image, batch.get(0));
+    REQUIRE(report.covered == report.instructions);
+    REQUIRE(report.directionsCovered == report.directions);
+    REQUIRE(format_coverage(report) == "instructions 12/12, branch directions 4/4\n");
+
+    //untouched program stays empty
+    REQUIRE(batch.get(1).executed.none());
+    REQUIRE_THROWS_AS(batch.merge(2, CoverageMap{}), std::runtime_error);
+}
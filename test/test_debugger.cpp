@@ -0,0 +1,145 @@
+#include "catch2/catch.hpp"
+#include "debugger.h"
+#include "test_programs.h"
+
+#include <sstream>
+
+TEST_CASE("Debugger forward and reverse stepping", "[Debugger]") {
+    const std::array<int, memorySize> image = countdownProgram(30);
+
+    //reference states after every instruction
+    std::vector<MachineState> history(1);
+    history[0].memory = image;
+    while (step(history.back(), {}), history.back().instructionRegister != 4300)
+        history.push_back(history.back());
+    const size_t total = history.size();
+
+    //small interval so reverse steps cross many checkpoints
+    Debugger debugger(image, {}, 7);
+    REQUIRE(debugger.continue_run() == StopReason::halted);
+    REQUIRE(debugger.finished());
+    REQUIRE(debugger.executed() == total);
+    REQUIRE(debugger.state().memory[21] == 465);
+    REQUIRE(debugger.step() == StopReason::halted);
+
+    //every reverse step lands on the same state as the forward run
+    for (size_t n = total; n-- > 0;)
+    {
+        REQUIRE(debugger.reverse_step() == StopReason::stepped);
+        REQUIRE(debugger.executed() == n);
+        if (n > 0)
+            REQUIRE(debugger.state() == history[n - 1]);
+    }
+    REQUIRE(debugger.reverse_step() == StopReason::start);
+    REQUIRE(debugger.state().memory == image);
+    REQUIRE_FALSE(debugger.finished());
+
+    //and forward again reaches the same end
+    REQUIRE(debugger.continue_run() == StopReason::halted);
+    REQUIRE(debugger.state().memory[21] == 465);
+}
+
+TEST_CASE("Debugger thins checkpoints on long runs", "[Debugger]") {
+    const std::array<int, memorySize> image = countdownProgram(30);
+    std::vector<MachineState> history(1);
+    history[0].memory = image;
+    while (step(history.back(), {}), history.back().instructionRegister != 4300)
+        history.push_back(history.back());
+    const size_t total = history.size();
+
+    //an interval of one would keep a checkpoint per instruction
+    Debugger debugger(image, {}, 1);
+    REQUIRE(debugger.continue_run() == StopReason::halted);
+    REQUIRE(total > 4 * Debugger::checkpointLimit);
+    REQUIRE(debugger.checkpoint_count() <= Debugger::checkpointLimit);
+
+    for (size_t n = total; n-- > 0;)
+    {
+        REQUIRE(debugger.reverse_step() == StopReason::stepped);
+        REQUIRE(debugger.executed() == n);
+        if (n > 0)
+            REQUIRE(debugger.state() == history[n - 1]);
+    }
+    REQUIRE(debugger.reverse_step() == StopReason::start);
+    REQUIRE(debugger.checkpoint_count() <= Debugger::checkpointLimit);
+}
+
+TEST_CASE("Debugger breakpoints and watchpoints", "[Debugger]") {
+    Debugger debugger(countdownProgram(30), {}, 5);
+
+    //address breakpoint stops before the instruction, every loop pass
+    debugger.add_breakpoint(5);
+    REQUIRE(debugger.continue_run() == StopReason::breakpoint);
+    REQUIRE(debugger.state().instructionCounter == 5);
+    REQUIRE(debugger.state().memory[21] == 30);
+    REQUIRE(debugger.continue_run() == StopReason::breakpoint);
+    REQUIRE(debugger.state().memory[21] == 59);
+
+    //reverse continue goes back to the previous hit
+    REQUIRE(debugger.reverse_continue() == StopReason::breakpoint);
+    REQUIRE(debugger.state().memory[21] == 30);
+    REQUIRE(debugger.reverse_continue() == StopReason::start);
+
+    //watchpoint stops right after the write
+    debugger.clear_breakpoints();
+    debugger.add_watchpoint(20);
+    REQUIRE(debugger.continue_run() == StopReason::watchpoint);
+    REQUIRE(debugger.state().memory[20] == 29);
+    REQUIRE(debugger.state().instructionCounter == 8);
+
+    //opcode breakpoint on halt
+    debugger.clear_breakpoints();
+    debugger.add_opcode_breakpoint(43);
+    REQUIRE(debugger.continue_run() == StopReason::breakpoint);
+    REQUIRE(debugger.state().instructionCounter == 9);
+    REQUIRE(debugger.continue_run() == StopReason::halted);
+
+    //reverse continue stops before the write to a watched cell
+    debugger.clear_breakpoints();
+    debugger.add_watchpoint(21);
+    REQUIRE(debugger.reverse_continue() == StopReason::watchpoint);
+    REQUIRE(debugger.state().instructionCounter == 4);
+    REQUIRE(debugger.state().memory[21] == 464);
+
+    REQUIRE_THROWS_AS(debugger.add_breakpoint(100), std::runtime_error);
+}
+
+TEST_CASE("Debugger faults, budgets and commands", "[run_debugger]") {
+    std::array<int, memorySize> memory{ 0 };
+    memory[0] = 1010; //read with no input faults
+    Debugger faulting(memory, {});
+    REQUIRE(faulting.continue_run() == StopReason::faulted);
+    REQUIRE(faulting.executed() == 0);
+    REQUIRE(faulting.state().instructionRegister == 1010);
+
+    //undoing the fault restores the registers without changing the count
+    REQUIRE(faulting.reverse_step() == StopReason::stepped);
+    REQUIRE_FALSE(faulting.finished());
+    REQUIRE(faulting.executed() == 0);
+    REQUIRE(faulting.state().instructionRegister == 0);
+    REQUIRE(faulting.reverse_step() == StopReason::start);
+
+    //running off the end of memory is not counted either
+    memory[0] = 4099;
+    memory[99] = 2000;
+    Debugger offTheEnd(memory, {});
+    REQUIRE(offTheEnd.continue_run() == StopReason::faulted);
+    REQUIRE(offTheEnd.executed() == 2);
+    REQUIRE(offTheEnd.state().instructionCounter == memorySize);
+    memory[99] = 0;
+
+    memory[0] = 4000; //spins forever
+    Debugger spinning(memory, {});
+    REQUIRE(spinning.continue_run(100) == StopReason::budgetExceeded);
+    REQUIRE(spinning.executed() == 100);
+
+    //scripted session
+    Debugger debugger(countdownProgram(30), {});
+    std::istringstream in("b 9\nc\nr\nrs\nw 21\nrc\nq\n");
+    std::ostringstream out;
+    run_debugger(debugger, in, out);
+    const std::string text = out.str();
+    REQUIRE(text.find("breakpoint at 9 after") != std::string::npos);
+    REQUIRE(text.find("ac 0 ic 9 ir 4209") != std::string::npos);
+    REQUIRE(text.find("watchpoint at 4 after") != std::string::npos);
+}
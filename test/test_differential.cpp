@@ -0,0 +1,85 @@
+#include "catch2/catch.hpp"
+#include "differential.h"
+#include "interpreter.h"
+#include "test_programs.h"
+
+//interpreter that gets the accumulator wrong from the fifth instruction on
+static EngineRun brokenEngine(const std::array<int, memorySize>& image, const std::vector<int>& inputs, uint64_t budget)
+{
+    EngineRun result;
+    result.state.memory = image;
+    result.recordsOutputs = false;
+    NullObserver observer;
+    result.termination = run(result.state, inputs, budget, &result.executed, observer);
+    if (result.executed >= 5)
+        ++result.state.accumulator;
+    return result;
+}
+
+TEST_CASE("Engines agree with the reference", "[compare_engines]") {
+    const std::vector<Engine>& engines = alternative_engines();
+
+    //halting with outputs
+    REQUIRE(compare_engines(printingCountdownProgram(), { 3 }, engines).empty());
+    const EngineRun reference = run_reference(printingCountdownProgram(), { 3 }, 1000);
+    REQUIRE(reference.termination == Termination::halted);
+    REQUIRE(reference.outputs == std::vector<int>{ 3, 2, 1 });
+
+    //out of inputs and out of budget
+    REQUIRE(compare_engines(printingCountdownProgram(), {}, engines).empty());
+    REQUIRE(compare_engines(printingCountdownProgram(), { -1 }, engines, 5000).empty());
+
+    //overflow, divide by zero and running off the end of memory
+    std::array<int, memorySize> memory{ 0 };
+    memory[0] = 2010;
+    memory[1] = 3310;
+    memory[2] = 4001;
+    memory[10] = 99;
+    REQUIRE(compare_engines(memory, {}, engines).empty());
+    memory[1] = 3211;
+    REQUIRE(compare_engines(memory, {}, engines).empty());
+    memory = { 0 };
+    memory[98] = 2099;
+    memory[0] = 4098;
+    REQUIRE(compare_engines(memory, {}, engines).empty());
+
+    //engines are found by name
+    REQUIRE(std::string(find_engine("tiered").name) == "tiered");
+    REQUIRE_THROWS_AS(find_engine("nothing"), std::runtime_error);
+}
+
+TEST_CASE("First divergent instruction is found", "[compare_engines]") {
+    const std::vector<Divergence> divergences =
+        compare_engines(printingCountdownProgram(), { 3 }, { { "broken", brokenEngine } });
+    REQUIRE(divergences.size() == 1);
+
+    const Divergence& divergence = divergences[0];
+    REQUIRE(divergence.engine == "broken");
+    REQUIRE(divergence.instruction == 4);
+    REQUIRE(divergence.address == 4);
+    REQUIRE(divergence.field == "accumulator");
+    REQUIRE(divergence.actual.state.accumulator == divergence.expected.state.accumulator + 1);
+    REQUIRE(format_divergence(divergence)
+        == "broken: instruction 4 at address 4, accumulator differs (reference budgetExceeded, engine budgetExceeded)");
+}
+
+TEST_CASE("Differences are named by field", "[first_difference]") {
+    EngineRun a;
+    EngineRun b;
+    REQUIRE(first_difference(a, b).empty());
+
+    b.state.memory[42] = 1;
+    REQUIRE(first_difference(a, b) == "memory[42]");
+    b.state.inputIndex = 1;
+    REQUIRE(first_difference(a, b) == "inputIndex");
+
+    //fields an engine cannot report are skipped
+    b = a;
+    b.executed = 3;
+    b.countsExecuted = false;
+    b.outputs = { 7 };
+    b.recordsOutputs = false;
+    REQUIRE(first_difference(a, b).empty());
+    b.termination = Termination::faulted;
+    REQUIRE(first_difference(a, b) == "termination");
+}
@@ -0,0 +1,73 @@
+#include "catch2/catch.hpp"
+#include "disassembler.h"
+#include "test_programs.h"
+
+#include <filesystem>
+#include <fstream>
+
+TEST_CASE("Cells are classified as code or data", "[classify_cells]") {
+    const std::array<CellKind, memorySize> kinds = classify_cells(selfPatchingCountdownProgram());
+    for (size_t address = 0; address <= 8; ++address)
+        REQUIRE(kinds[address] == CellKind::code);
+    REQUIRE(kinds[20] == CellKind::data);
+    REQUIRE(kinds[21] == CellKind::data);
+    REQUIRE(kinds[22] == CellKind::data);
+    REQUIRE(kinds[30] == CellKind::unused);
+    REQUIRE(kinds[9] == CellKind::unused);
+}
+
+TEST_CASE("Listing is annotated", "[disassemble]") {
+    REQUIRE(disassemble(selfPatchingCountdownProgram()) ==
+        "L00:  ; loop\n"
+        "    00  +2020  load       20\n"
+        "    01  +4206  branchZero L06\n"
+        "L02:\n"
+        "    02  +3121  subtract   21\n"
+        "    03  +2120  store      20\n"
+        "    04  +1120  write      20\n"
+        "    05  +4000  branch     L00\n"
+        "L06:\n"
+        "    06  +2022  load       22\n"
+        "    07  +2104  store      04 ; writes code\n"
+        "    08  +4300  halt\n"
+        "    20  +0003  data\n"
+        "    21  +0001  data\n"
+        "    22  +4300  data\n"
+        "    30  +0077  data ; unreferenced\n");
+
+    //undefined instructions and code running past the last word
+    std::array<int, memorySize> memory{ 0 };
+    memory[0] = 4098;
+    memory[98] = -2010;
+    memory[99] = 0;
+    REQUIRE(disassemble(memory) ==
+        "L00:\n"
+        "    00  +4098  branch     L98\n"
+        "L98:\n"
+        "    98  -2010  halt ; undefined, halts\n");
+    memory[98] = 2010;
+    memory[99] = 2111;
+    REQUIRE(disassemble(memory) ==
+        "L00:\n"
+        "    00  +4098  branch     L98\n"
+        "    10  +0000  data\n"
+        "    11  +0000  data\n"
+        "L98:\n"
+        "    98  +2010  load       10\n"
+        "    99  +2111  store      11 ; falls off memory\n");
+}
+
+TEST_CASE("Batch listings name each program", "[disassemble_batch]") {
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "computron_listing.txt";
+    {
+        std::ofstream out(path);
+        out << "+1009\n+4300\n-99999\n+2005\n+4300\n-99999\n";
+    }
+
+    const ProgramBatch batch = load_batch(path.string());
+    const std::string name = path.filename().string();
+    REQUIRE(disassemble_batch(batch) ==
+        "; " + name + "#0\nL00:\n    00  +1009  read       09\n    01  +4300  halt\n    09  +0000  data\n\n"
+        "; " + name + "#1\nL00:\n    00  +2005  load       05\n    01  +4300  halt\n    05  +0000  data\n\n");
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,85 @@
+#include "catch2/catch.hpp"
+#include "computron.h"
+
+#include <iomanip>
+#include <random>
+#include <sstream>
+
+#include <unistd.h>
+
+//the original stream based dump, kept as the reference for the fast path
+static std::string streamDump(const std::array<int, memorySize>& memory, int accumulator,
+    size_t instructionCounter, size_t instructionRegister,
+    size_t operationCode, size_t operand)
+{
+    std::ostringstream out;
+    out << "Memory:" << "\n" << "    ";
+    for (int col = 0; col < 10; col++)
+        out << col << "    ";
+    out << "\n";
+    for (int row = 0; row < 10; ++row) {
+        out << std::setw(2) << row * 10 << " ";
+        for (int col = 0; col < 10; ++col)
+        {
+            int val = memory[row * 10 + col];
+            out << (val < 0 ? "-" : "+") << std::setw(4) << std::setfill('0') << abs(val);
+        }
+        out << "\n";
+    }
+    out << '\n' << "Registers" << '\n';
+    auto line = [&](const std::string& label, int width, int value, bool sign) {
+        out << std::setw(22) << std::setfill(' ') << std::left << label << "\t" << std::right;
+        if (sign)
+            out << (value < 0 ? "-" : "+");
+        out << std::setfill('0') << std::setw(width) << abs(value) << '\n';
+    };
+    line("Accumulator", 4, accumulator, true);
+    line("instructionCounter", 2, instructionCounter, false);
+    line("instructionRegister", 4, instructionRegister, true);
+    line("operationCode", 2, operationCode, false);
+    line("operand", 2, operand, false);
+    out << '\n';
+    return out.str();
+}
+
+TEST_CASE("Fast dump matches stream formatting", "[format_dump]") {
+    char buffer[dumpBufferSize];
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int> word(minWord, maxWord);
+
+    //random machine states, including words read from out of range inputs
+    for (int trial = 0; trial < 200; trial++)
+    {
+        std::array<int, memorySize> memory;
+        for (int& cell : memory)
+            cell = word(random);
+        memory[trial % memorySize] = trial % 2 ? 123456789 : -99999;
+        const int accumulator = word(random);
+        const int instructionRegister = word(random);
+
+        const size_t size = format_dump(buffer, memory, accumulator, trial % 100,
+            instructionRegister, instructionRegister / 100, instructionRegister % 100);
+        REQUIRE(std::string(buffer, size) == streamDump(memory, accumulator, trial % 100,
+            instructionRegister, instructionRegister / 100, instructionRegister % 100));
+    }
+}
+
+TEST_CASE("Dump to file descriptor", "[dump_to_fd]") {
+    std::array<int, memorySize> memory{ 0 };
+    load_from_file(memory, "p1.txt");
+
+    //read back what a single write produced
+    int fds[2];
+    REQUIRE(::pipe(fds) == 0);
+    dump_to_fd(fds[1], memory, 9, 6, 4300, 43, 0);
+    ::close(fds[1]);
+    std::string text(dumpBufferSize, '\0');
+    text.resize(::read(fds[0], text.data(), text.size()));
+    ::close(fds[0]);
+
+    REQUIRE(text == streamDump(memory, 9, 6, 4300, 43, 0));
+    REQUIRE(text.find(" 0 +1007+1008+2007+3008+2109+1109+4300+0000+0000+0000\n") != std::string::npos);
+    REQUIRE(text.find("Accumulator           \t+0009\n") != std::string::npos);
+
+    REQUIRE_THROWS_AS(dump_to_fd(-1, memory, 0, 0, 0, 0, 0), std::runtime_error);
+}
@@ -0,0 +1,136 @@
+#include "catch2/catch.hpp"
+#include "differential.h"
+#include "expression_dag.h"
+#include "interpreter.h"
+
+#include <limits>
+
+//reads a, b and c, stores (a + b) * c into mem[30] and a / b into mem[31]
+static std::array<int, memorySize> formulaProgram()
+{
+    std::array<int, memorySize> memory{ 0 };
+    memory[0] = 1020; //read a
+    memory[1] = 1021; //read b
+    memory[2] = 1022; //read c
+    memory[3] = 2020; //load a
+    memory[4] = 3021; //add b
+    memory[5] = 3322; //multiply c
+    memory[6] = 2130; //store 30
+    memory[7] = 1130; //write 30
+    memory[8] = 2020; //load a
+    memory[9] = 3221; //divide b
+    memory[10] = 2131; //store 31
+    memory[11] = 4300;
+    return memory;
+}
+
+TEST_CASE("Straight-line programs become dags", "[build_dag]") {
+    const ExpressionDag dag = build_dag(formulaProgram());
+    REQUIRE(dag.built);
+    REQUIRE(dag.reads == 3);
+    REQUIRE(dag.executed == 12);
+    REQUIRE(dag.halt == 11);
+    REQUIRE(dag.nodes.size() == 6); //three inputs, add, multiply, divide
+    REQUIRE(dag.outputs == std::vector<size_t>{ 4 });
+    REQUIRE(dag.stores.size() == 5);
+
+    //a test of a constant is followed, a test of input is not
+    std::array<int, memorySize> constantTest{ 0 };
+    constantTest[0] = 2010; //load 10
+    constantTest[1] = 4104; //negative, so over the write
+    constantTest[2] = 1110;
+    constantTest[3] = 4300;
+    constantTest[4] = 1110;
+    constantTest[5] = 4300;
+    constantTest[10] = -5;
+    const ExpressionDag followed = build_dag(constantTest);
+    REQUIRE(followed.built);
+    REQUIRE(followed.halt == 5);
+
+    std::array<int, memorySize> inputTest{ 0 };
+    inputTest[0] = 1010; //read 10
+    inputTest[1] = 2010;
+    inputTest[2] = 4104;
+    inputTest[3] = 4300;
+    inputTest[4] = 4300;
+    REQUIRE_FALSE(build_dag(inputTest).built);
+
+    //loops and writes into code do not build
+    std::array<int, memorySize> spin{ 0 };
+    spin[0] = 4000;
+    REQUIRE_FALSE(build_dag(spin).built);
+    std::array<int, memorySize> selfModifying = formulaProgram();
+    selfModifying[10] = 2111;
+    REQUIRE_FALSE(build_dag(selfModifying).built);
+}
+
+TEST_CASE("Batches end every row like the interpreter", "[run_dag_batch]") {
+    const std::array<int, memorySize> image = formulaProgram();
+    const ExpressionDag dag = build_dag(image);
+
+    //faults, missing and out of range inputs go to the interpreter
+    std::vector<std::vector<int>> rows;
+    for (int i = 0; i < 1000; ++i)
+        rows.push_back({ i * 7 % 199 - 99, i % 13 - 6, i % 101 });
+    rows.push_back({ 5, 0, 1 }); //divide by zero
+    rows.push_back({ 9999, 1, 1 }); //add overflows
+    rows.push_back({ 1, 2 }); //third read fails
+    rows.push_back({ 1, 2, 12345 }); //read takes any value
+    const DagBatchResult batch = run_dag_batch(dag, rows, 1000);
+    REQUIRE(batch.scalar.size() == 4 + 1000 / 13 + 1);
+
+    for (size_t row = 0; row < rows.size(); ++row)
+    {
+        EngineRun expected;
+        expected.state.memory = image;
+        OutputObserver observer(&expected.outputs);
+        expected.termination = run(expected.state, rows[row], 1000, &expected.executed, observer);
+
+        EngineRun actual;
+        actual.termination = batch_row(dag, batch, row, &actual.state, &actual.executed, &actual.outputs);
+        REQUIRE(first_difference(expected, actual).empty());
+    }
+    //one column per store, the accumulator, then the write
+    REQUIRE(batch.columns.size() == 7 * rows.size());
+    REQUIRE(batch.columns[3 * rows.size() + 7] == (7 * 7 - 99 + 1) * 7);
+
+    //a budget short of the halt runs every row in the interpreter
+    REQUIRE(run_dag_batch(dag, rows, 5).scalar.size() == rows.size());
+    REQUIRE(compare_engines(image, { 3, 4, 5 }, alternative_engines()).empty());
+}
+
+TEST_CASE("Image words outside the word range", "[run_dag_batch]") {
+    //loads take any image word, arithmetic on them faults like the interpreter
+    std::array<int, memorySize> image{ 0 };
+    image[0] = 1020; //read x
+    image[1] = 2021; //load 20000
+    image[2] = 3220; //divide x
+    image[3] = 2130; //store 30
+    image[4] = 2022; //load INT_MIN
+    image[5] = 3220; //divide x
+    image[6] = 2131; //store 31
+    image[7] = 2022; //load INT_MIN
+    image[8] = 3223; //divide -1, not folded
+    image[9] = 2132; //store 32
+    image[10] = 4300;
+    image[21] = 20000;
+    image[22] = std::numeric_limits<int>::min();
+    image[23] = -1;
+    const ExpressionDag dag = build_dag(image);
+    REQUIRE(dag.built);
+
+    const std::vector<std::vector<int>> rows{ { -1 }, { 1 }, { 4 }, { 9999 }, { 0 } };
+    const DagBatchResult batch = run_dag_batch(dag, rows, 1000);
+    for (size_t row = 0; row < rows.size(); ++row)
+    {
+        EngineRun expected;
+        expected.state.memory = image;
+        OutputObserver observer(&expected.outputs);
+        expected.termination = run(expected.state, rows[row], 1000, &expected.executed, observer);
+
+        EngineRun actual;
+        actual.termination = batch_row(dag, batch, row, &actual.state, &actual.executed, &actual.outputs);
+        REQUIRE(expected.termination == Termination::faulted);
+        REQUIRE(first_difference(expected, actual).empty());
+    }
+}
@@ -0,0 +1,117 @@
+#include "catch2/catch.hpp"
+#include "interpreter.h"
+#include "test_programs.h"
+
+#include <limits>
+#include <type_traits>
+
+namespace
+{
+    //counts every callback
+    struct CountingObserver : NullObserver
+    {
+        int fetches{ 0 }, reads{ 0 }, writes{ 0 }, taken{ 0 }, notTaken{ 0 }, faults{ 0 };
+        size_t lastWrite{ 0 };
+        void on_fetch(size_t, int) { fetches++; }
+        void on_mem_read(size_t, int) { reads++; }
+        void on_mem_write(size_t address, int) { writes++; lastWrite = address; }
+        void on_branch(size_t, size_t, bool wasTaken) { wasTaken ? taken++ : notTaken++; }
+        void on_fault(size_t, int) { faults++; }
+    };
+}
+
+TEST_CASE("Observed interpreter loop", "[run]") {
+    //null observer carries no state at all
+    REQUIRE(std::is_empty_v<NullObserver>);
+
+    //count down mem[20] from 3, adding into mem[21]
+    MachineState state;
+    state.memory = countdownProgram(3);
+
+    CountingObserver observer;
+    uint64_t executed{ 0 };
+    REQUIRE(run(state, {}, 1000, &executed, observer) == Termination::halted);
+    REQUIRE(state.memory[21] == 6);
+    REQUIRE(executed == 3 * 9 + 3);
+    REQUIRE(observer.fetches == 30);
+    REQUIRE(observer.writes == 6);
+    REQUIRE(observer.reads == 3 * 5 + 1);
+    REQUIRE(observer.taken == 4);
+    REQUIRE(observer.notTaken == 3);
+    REQUIRE(observer.faults == 0);
+
+    //budget stops mid run and the run resumes from there
+    state.memory[20] = 3;
+    state.memory[21] = 0;
+    state.instructionCounter = 0;
+    executed = 0;
+    NullObserver none;
+    REQUIRE(run(state, {}, 10, &executed, none) == Termination::budgetExceeded);
+    REQUIRE(executed == 10);
+    REQUIRE(run(state, {}, 1000, &executed, none) == Termination::halted);
+    REQUIRE(executed == 30);
+    REQUIRE(state.memory[21] == 6);
+}
+
+TEST_CASE("Observed outputs", "[OutputObserver]") {
+    //loads and adds read memory too, only writes are collected
+    MachineState state;
+    state.memory[0] = 1109;
+    state.memory[1] = 2009;
+    state.memory[2] = 3009;
+    state.memory[3] = 2109;
+    state.memory[4] = 1109;
+    state.memory[5] = 4300;
+    state.memory[9] = 21;
+
+    std::vector<int> outputs;
+    OutputObserver observer(&outputs);
+    uint64_t executed{ 0 };
+    REQUIRE(run(state, {}, 100, &executed, observer) == Termination::halted);
+    REQUIRE(outputs == std::vector<int>{ 21, 42 });
+
+    //a null vector collects nothing
+    state.memory[9] = 21;
+    state.instructionCounter = 0;
+    OutputObserver discard(nullptr);
+    REQUIRE(run(state, {}, 100, &executed, discard) == Termination::halted);
+    REQUIRE(state.memory[9] == 42);
+}
+
+TEST_CASE("Observed faults", "[run]") {
+    //overflow reports the faulting instruction and leaves the counter on it
+    MachineState state;
+    state.memory[0] = 2010;
+    state.memory[1] = 3310;
+    state.memory[10] = 9999;
+    CountingObserver observer;
+    uint64_t executed{ 0 };
+    REQUIRE(run(state, {}, 100, &executed, observer) == Termination::faulted);
+    REQUIRE(executed == 1);
+    REQUIRE(observer.faults == 1);
+    REQUIRE(state.instructionCounter == 1);
+    REQUIRE(state.instructionRegister == 3310);
+    REQUIRE(state.accumulator == 9999);
+    REQUIRE_THROWS_AS(step(state, {}), std::runtime_error);
+
+    //falling off the end of memory faults too
+    MachineState offEnd;
+    offEnd.memory[0] = 4099;
+    offEnd.memory[99] = 2000;
+    executed = 0;
+    REQUIRE(run(offEnd, {}, 100, &executed, observer) == Termination::faulted);
+    REQUIRE(offEnd.instructionCounter == 100);
+    REQUIRE(executed == 2);
+
+    //reads store any int, so INT_MIN / -1 has to fault rather than trap
+    MachineState divide;
+    divide.memory[0] = 1010;
+    divide.memory[1] = 1011;
+    divide.memory[2] = 2010;
+    divide.memory[3] = 3211;
+    const std::vector<int> inputs{ std::numeric_limits<int>::min(), -1 };
+    executed = 0;
+    REQUIRE(run(divide, inputs, 100, &executed, observer) == Termination::faulted);
+    REQUIRE(divide.instructionCounter == 3);
+    REQUIRE(divide.accumulator == std::numeric_limits<int>::min());
+}
@@ -0,0 +1,41 @@
+#include "catch2/catch.hpp"
+#include "isa.h"
+
+#include <cstring>
+
+TEST_CASE("Decode table follows the instruction set", "[isa]") {
+    for (const InstructionInfo& info : instructionSet)
+    {
+        REQUIRE(static_cast<size_t>(info.command) == info.opCode);
+        REQUIRE(decode_opcode(info.opCode) == info.command);
+        REQUIRE(defined_opcode(info.opCode));
+        REQUIRE(std::strcmp(command_info(info.command).mnemonic, info.mnemonic) == 0);
+    }
+
+    //everything outside the set runs as halt
+    size_t defined{ 0 };
+    for (size_t opCode = 0; opCode < opCodeCount; ++opCode)
+    {
+        if (defined_opcode(opCode))
+            ++defined;
+        else
+            REQUIRE(decode_opcode(opCode) == Command::halt);
+    }
+    REQUIRE(defined == instructionSet.size());
+    REQUIRE(decode_opcode(5000) == Command::halt);
+    REQUIRE(opCodeToCommand(33) == Command::multiply);
+}
+
+TEST_CASE("Words decode with their flags", "[isa]") {
+    REQUIRE(word_info(2107).command == Command::store);
+    REQUIRE(word_info(2107).flags & flagWritesMemory);
+    REQUIRE(word_info(4105).flags & flagConditional);
+    REQUIRE_FALSE(word_info(4005).flags & flagConditional);
+    REQUIRE(word_info(4005).operand == OperandKind::target);
+    REQUIRE(word_info(3210).cost > word_info(2010).cost);
+
+    //negative words decode to a huge opcode and halt
+    REQUIRE(word_info(-1010).command == Command::halt);
+    REQUIRE(word_info(-1010).operand == OperandKind::none);
+    REQUIRE(word_info(12345).command == Command::halt);
+}
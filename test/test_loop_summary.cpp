@@ -0,0 +1,66 @@
+#include "catch2/catch.hpp"
+#include "differential.h"
+#include "loop_summary.h"
+#include "test_programs.h"
+
+TEST_CASE("Counted loops get summaries", "[summarize_loops]") {
+    const LoopSummaries summation = summarize_loops(countdownProgram(100));
+    REQUIRE(summation.loops.size() == 1);
+    REQUIRE(summation.loopAt[0] == 0);
+    REQUIRE(summation.loops[0].length == 9);
+    REQUIRE(summation.loops[0].test == 1);
+    REQUIRE(summation.loops[0].latch == 8);
+    REQUIRE(summation.loops[0].exitWhenTaken);
+    REQUIRE(summation.loops[0].degree == 2); //the sum of a counter
+
+    const LoopSummaries multiply = summarize_loops(multiplyProgram());
+    REQUIRE(multiply.loops.size() == 1);
+    REQUIRE(multiply.loops[0].header == 2);
+    REQUIRE(multiply.loops[0].degree == 1);
+
+    //loops that read, or images that write into code, are left alone
+    std::array<int, memorySize> reading{ 0 };
+    reading[0] = 1020;
+    reading[1] = 2020;
+    reading[2] = 4200;
+    REQUIRE(summarize_loops(reading).loops.empty());
+    std::array<int, memorySize> selfModifying = countdownProgram(5);
+    selfModifying[7] = 2109; //n -= 1 lands on the halt
+    REQUIRE(summarize_loops(selfModifying).loops.empty());
+}
+
+TEST_CASE("Summarized runs end like the reference", "[run_summarized]") {
+    const Engine& summarized = find_engine("summarized");
+
+    //halting, overflowing on the exact iteration and every budget cut
+    for (int n : { 0, 1, 100, 140, 141, 9999 })
+    {
+        const std::array<int, memorySize> image = countdownProgram(n);
+        REQUIRE(first_difference(run_reference(image, {}, 1'000'000), summarized.run(image, {}, 1'000'000)).empty());
+    }
+    REQUIRE(summarized.run(countdownProgram(100), {}, 1000).state.memory[21] == 5050);
+    REQUIRE(summarized.run(countdownProgram(141), {}, 10'000).termination == Termination::faulted);
+    for (uint64_t budget = 0; budget < 200; ++budget)
+        REQUIRE(first_difference(run_reference(countdownProgram(20), {}, budget),
+            summarized.run(countdownProgram(20), {}, budget)).empty());
+
+    for (const std::vector<int>& inputs : std::vector<std::vector<int>>{ { 6, 7 }, { 99, 101 }, { -3, 4 }, { 9999, 1 }, { 9999, 2 } })
+        REQUIRE(first_difference(run_reference(multiplyProgram(), inputs, 100'000),
+            summarized.run(multiplyProgram(), inputs, 100'000)).empty());
+    REQUIRE(compare_engines(countdownProgram(60), {}, alternative_engines()).empty());
+}
+
+TEST_CASE("A loop that never leaves costs nothing", "[run_summarized]") {
+    //load zero, branchZero back, forever
+    std::array<int, memorySize> image{ 0 };
+    image[0] = 2010;
+    image[1] = 4200;
+    image[2] = 4300;
+
+    const uint64_t budget{ 1'000'000'000'000'001 };
+    const EngineRun run = find_engine("summarized").run(image, {}, budget);
+    REQUIRE(run.termination == Termination::budgetExceeded);
+    REQUIRE(run.executed == budget);
+    REQUIRE(run.state.instructionCounter == 1);
+    REQUIRE(run.state.instructionRegister == 2010);
+}
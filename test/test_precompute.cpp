@@ -0,0 +1,69 @@
+#include "catch2/catch.hpp"
+#include "differential.h"
+#include "precompute.h"
+
+//doubles mem[20] into mem[21] and writes it, then reads x and writes x + 1
+static std::array<int, memorySize> prefixProgram()
+{
+    std::array<int, memorySize> memory{ 0 };
+    memory[0] = 2020; //load 20
+    memory[1] = 3020; //add 20
+    memory[2] = 2121; //store 21
+    memory[3] = 1121; //write 21
+    memory[4] = 1022; //read 22
+    memory[5] = 2022; //load 22
+    memory[6] = 3023; //add 23
+    memory[7] = 2122; //store 22
+    memory[8] = 1122; //write 22
+    memory[9] = 4300;
+    memory[20] = 21;
+    memory[23] = 1;
+    return memory;
+}
+
+TEST_CASE("Prefixes stop at the first read", "[precompute]") {
+    const Precomputed prefix = precompute(prefixProgram());
+    REQUIRE_FALSE(prefix.complete);
+    REQUIRE(prefix.executed == 4);
+    REQUIRE(prefix.state.instructionCounter == 4);
+    REQUIRE(prefix.state.memory[21] == 42);
+    REQUIRE(prefix.outputs == std::vector<int>{ 42 });
+
+    //a program without reads is done at load time, faults included
+    std::array<int, memorySize> complete = prefixProgram();
+    complete[4] = 2020;
+    const Precomputed halted = precompute(complete);
+    REQUIRE(halted.complete);
+    REQUIRE(halted.termination == Termination::halted);
+    REQUIRE(halted.executed == 10);
+    REQUIRE(halted.outputs == std::vector<int>{ 42, 1 });
+
+    complete[20] = 9000;
+    const Precomputed faulted = precompute(complete);
+    REQUIRE(faulted.complete);
+    REQUIRE(faulted.termination == Termination::faulted);
+    REQUIRE(faulted.executed == 1);
+
+    //the limit keeps a prefix of a run that never reads
+    std::array<int, memorySize> spin{ 0 };
+    spin[0] = 4000;
+    const Precomputed spinning = precompute(spin, 500);
+    REQUIRE_FALSE(spinning.complete);
+    REQUIRE(spinning.executed == 500);
+}
+
+TEST_CASE("Runs from a prefix end like runs from the start", "[run_precomputed]") {
+    std::array<int, memorySize> complete = prefixProgram();
+    complete[4] = 2020;
+    std::array<int, memorySize> overflowing = complete;
+    overflowing[20] = 9000;
+
+    for (const std::array<int, memorySize>& image : { prefixProgram(), complete, overflowing })
+    {
+        const Precomputed precomputed = precompute(image);
+        for (uint64_t budget = 0; budget < 14; ++budget)
+            for (const std::vector<int>& inputs : std::vector<std::vector<int>>{ {}, { 5 }, { 9999 } })
+                REQUIRE(first_difference(run_reference(image, inputs, budget), run_precomputed_engine(precomputed, inputs, budget)).empty());
+    }
+    REQUIRE(compare_engines(prefixProgram(), { 7 }, alternative_engines()).empty());
+}
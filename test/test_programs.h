@@ -0,0 +1,83 @@
+#ifndef TEST_PROGRAMS_H
+#define TEST_PROGRAMS_H
+
+#include "computron.h"
+
+//program images shared by the test files
+
+//counts mem[20] down from n to zero, adding it into mem[21] each time
+inline std::array<int, memorySize> countdownProgram(int n)
+{
+    std::array<int, memorySize> memory{ 0 };
+    memory[0] = 2020; //loop: load n
+    memory[1] = 4209; //zero ends the loop
+    memory[2] = 2021; //sum += n
+    memory[3] = 3020;
+    memory[4] = 2121;
+    memory[5] = 2020; //n -= 1
+    memory[6] = 3122;
+    memory[7] = 2120;
+    memory[8] = 4000;
+    memory[9] = 4300;
+    memory[20] = n;
+    memory[22] = 1;
+    return memory;
+}
+
+//reads x and prints x, x-1, ..., 1, then halts
+inline std::array<int, memorySize> printingCountdownProgram()
+{
+    std::array<int, memorySize> memory{ 0 };
+    memory[0] = 1020; //read x
+    memory[1] = 1120; //write x
+    memory[2] = 2020; //load x
+    memory[3] = 3121; //subtract 1
+    memory[4] = 2120; //store x
+    memory[5] = 4207; //zero: done
+    memory[6] = 4001;
+    memory[7] = 4300;
+    memory[21] = 1;
+    return memory;
+}
+
+//counts down from mem[20] and stores a halt over its own write at the end
+inline std::array<int, memorySize> selfPatchingCountdownProgram()
+{
+    std::array<int, memorySize> memory{ 0 };
+    memory[0] = 2020; //loop: load n
+    memory[1] = 4206; //zero: done
+    memory[2] = 3121; //subtract one
+    memory[3] = 2120; //store n
+    memory[4] = 1120; //write n
+    memory[5] = 4000;
+    memory[6] = 2022; //done: load halt
+    memory[7] = 2104; //store over the write
+    memory[8] = 4300;
+    memory[20] = 3;
+    memory[21] = 1;
+    memory[22] = 4300;
+    memory[30] = 77; //nothing names this
+    return memory;
+}
+
+//multiplies two inputs by repeated addition into mem[50]
+inline std::array<int, memorySize> multiplyProgram()
+{
+    std::array<int, memorySize> memory{ 0 };
+    memory[0] = 1040; //read a
+    memory[1] = 1041; //read b
+    memory[2] = 2041; //loop: load b
+    memory[3] = 4211; //zero: done
+    memory[4] = 3142; //subtract 1
+    memory[5] = 2141; //store b
+    memory[6] = 2050; //load sum
+    memory[7] = 3040; //add a
+    memory[8] = 2150; //store sum
+    memory[9] = 4002;
+    memory[11] = 1150; //write sum
+    memory[12] = 4300;
+    memory[42] = 1;
+    return memory;
+}
+
+#endif
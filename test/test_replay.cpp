@@ -0,0 +1,99 @@
+#include "catch2/catch.hpp"
+#include "replay.h"
+
+#include <sstream>
+
+//sums the inputs until a zero is read, writing the running total each time
+static std::array<int, memorySize> summingProgram()
+{
+    std::array<int, memorySize> memory{ 0 };
+    memory[0] = 1020; //loop: read x
+    memory[1] = 2020; //load x
+    memory[2] = 4209; //zero ends the loop
+    memory[3] = 2021; //total += x
+    memory[4] = 3020;
+    memory[5] = 2121;
+    memory[6] = 1121; //write total
+    memory[7] = 4000; //next input
+    memory[9] = 4300;
+    return memory;
+}
+
+TEST_CASE("Record and replay a run", "[record_run]") {
+    const std::array<int, memorySize> image = summingProgram();
+    std::vector<int> inputs;
+    for (int i = 1; i <= 50; i++)
+        inputs.push_back(i);
+    inputs.push_back(0);
+    inputs.push_back(77); //never read
+
+    const RunLog log = record_run(image, inputs, 16);
+    REQUIRE(log.termination == Termination::halted);
+    REQUIRE(log.executed == 50 * 8 + 4);
+    REQUIRE(log.inputs.size() == 51);
+    REQUIRE(log.outputs.size() == 50);
+    REQUIRE(log.outputs.back() == 1275);
+    REQUIRE(log.final.memory[21] == 1275);
+    REQUIRE(log.checkpoints.size() == 26);
+    REQUIRE(log.checkpoints[1].executed == 16);
+
+    //replay matches, and a changed image or input does not
+    REQUIRE(replay_run(image, log));
+    RunLog tampered = log;
+    tampered.inputs[3] = 100;
+    REQUIRE_FALSE(replay_run(image, tampered));
+    std::array<int, memorySize> other = image;
+    other[50] = 1;
+    REQUIRE_FALSE(replay_run(other, log));
+
+    //seeking matches a straight run of the same length
+    for (uint64_t target : { 0, 5, 16, 17, 100, 403, 404, 900 })
+    {
+        MachineState expected;
+        expected.memory = image;
+        for (uint64_t i = 0; i < target && i < log.executed; i++)
+            step(expected, log.inputs);
+        REQUIRE(seek_run(image, log, target) == expected);
+    }
+
+    //log survives a round trip through its binary form
+    std::stringstream file;
+    write_run_log(file, log, image);
+    REQUIRE(file.str().size() < 10 * 1024);
+    const RunLog back = read_run_log(file, image);
+    REQUIRE(back.final == log.final);
+    REQUIRE(back.outputs == log.outputs);
+    REQUIRE(back.checkpoints.size() == log.checkpoints.size());
+    REQUIRE(back.checkpoints[20].state == log.checkpoints[20].state);
+    REQUIRE(replay_run(image, back));
+
+    std::stringstream garbage("not a log");
+    REQUIRE_THROWS_AS(read_run_log(garbage, image), std::runtime_error);
+
+    //a corrupt input count is refused rather than allocated
+    std::string corrupt{ file.str() };
+    const size_t inputCount{ 8 + 8 + 8 + 1 + 8 };
+    corrupt.replace(inputCount, 4, "\xFF\xFF\xFF\xFF");
+    std::stringstream corruptFile(corrupt);
+    REQUIRE_THROWS_AS(read_run_log(corruptFile, image), std::runtime_error);
+
+    //and so is a log cut off among its checkpoints
+    std::stringstream truncated(file.str().substr(0, file.str().size() - 30));
+    REQUIRE_THROWS_AS(read_run_log(truncated, image), std::runtime_error);
+}
+
+TEST_CASE("Replay faults and budgets", "[replay_run]") {
+    const std::array<int, memorySize> image = summingProgram();
+
+    //running out of input faults the same way on replay
+    RunLog log = record_run(image, { 1, 2 }, 4);
+    REQUIRE(log.termination == Termination::faulted);
+    REQUIRE(log.final.instructionCounter == 0);
+    REQUIRE(replay_run(image, log));
+
+    //budget stops are reproduced at the same instruction
+    log = record_run(image, { 1, 2, 3, 4, 0 }, 4, 10);
+    REQUIRE(log.termination == Termination::budgetExceeded);
+    REQUIRE(log.executed == 10);
+    REQUIRE(replay_run(image, log));
+}
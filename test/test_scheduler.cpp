@@ -0,0 +1,97 @@
+#include "catch2/catch.hpp"
+#include "scheduler.h"
+
+#include <limits>
+
+TEST_CASE("Single step execution", "[step]") {
+    MachineState state;
+    const std::vector<int> inputs{ 4, 5 };
+    load_from_file(state.memory, "p1.txt");
+
+    //step through until halt, counting instructions
+    size_t steps{ 1 };
+    while (step(state, inputs) != Command::halt)
+        steps++;
+
+    //same final state as execute
+    REQUIRE(steps == 7);
+    REQUIRE(state.memory[9] == 9);
+    REQUIRE(state.accumulator == 9);
+    REQUIRE(state.instructionCounter == 6);
+    REQUIRE(state.inputIndex == 2);
+}
+
+TEST_CASE("Scheduler runs many jobs", "[Scheduler]") {
+    std::array<int, memorySize> program{ 0 };
+    load_from_file(program, "p1.txt");
+
+    //infinite loop, only stopped by its budget
+    std::array<int, memorySize> spin{ 0 };
+    spin[0] = 4000;
+
+    //divide by zero fault
+    std::array<int, memorySize> fault{ 0 };
+    fault[0] = 3205;
+
+    Scheduler scheduler(4, 3);
+    std::vector<size_t> ids;
+    for (int i = 0; i < 200; i++)
+        ids.push_back(scheduler.submit(program, { i, 1 }));
+    const size_t spinId = scheduler.submit(spin, {}, 1, 50);
+    const size_t faultId = scheduler.submit(fault, {});
+    scheduler.wait();
+
+    //every sum job halted with its own result
+    for (int i = 0; i < 200; i++)
+    {
+        const JobResult& result = scheduler.result(ids[i]);
+        REQUIRE(result.status == JobStatus::halted);
+        REQUIRE(result.state.memory[9] == i + 1);
+        REQUIRE(result.executed == 7);
+        REQUIRE(result.quanta == 3);
+    }
+
+    //budget and fault reported per job
+    REQUIRE(scheduler.result(spinId).status == JobStatus::budgetExceeded);
+    REQUIRE(scheduler.result(spinId).executed == 50);
+    REQUIRE(scheduler.result(faultId).status == JobStatus::faulted);
+    REQUIRE(scheduler.result(faultId).state.instructionRegister == 3205);
+    REQUIRE(scheduler.result(faultId).executed == 0);
+
+    //unknown job
+    REQUIRE_THROWS_AS(scheduler.result(500), std::runtime_error);
+}
+
+TEST_CASE("Scheduler fair share by priority", "[Scheduler]") {
+    std::array<int, memorySize> spin{ 0 };
+    spin[0] = 4000;
+
+    //one worker makes the interleaving deterministic
+    Scheduler scheduler(1, 100);
+    const size_t low = scheduler.submit(spin, {}, 1, 4000);
+    const size_t high = scheduler.submit(spin, {}, 4, 4000);
+    scheduler.wait();
+
+    //high priority gets four times the share, so it finishes first
+    REQUIRE(scheduler.result(high).finishOrder == 0);
+    REQUIRE(scheduler.result(low).finishOrder == 1);
+    REQUIRE(scheduler.result(high).executed == 4000);
+    REQUIRE(scheduler.result(low).executed == 4000);
+}
+
+TEST_CASE("Scheduler clamps very large priorities", "[Scheduler]") {
+    std::array<int, memorySize> spin{ 0 };
+    spin[0] = 4000;
+
+    //a huge priority still advances its pass, so a priority 1 job keeps
+    //getting turns long before the greedy job reaches its budget
+    Scheduler scheduler(1, 1);
+    const size_t greedy = scheduler.submit(spin, {}, std::numeric_limits<unsigned>::max(), 400'000);
+    const size_t other = scheduler.submit(spin, {}, 1, 3);
+    scheduler.wait();
+
+    REQUIRE(scheduler.result(other).finishOrder == 0);
+    REQUIRE(scheduler.result(other).executed == 3);
+    REQUIRE(scheduler.result(greedy).finishOrder == 1);
+    REQUIRE(scheduler.result(greedy).executed == 400'000);
+}
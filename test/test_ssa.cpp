@@ -0,0 +1,166 @@
+#include "catch2/catch.hpp"
+#include "differential.h"
+#include "ssa.h"
+#include "test_programs.h"
+
+#include <limits>
+
+static std::array<int, memorySize> program(std::initializer_list<int> words)
+{
+    std::array<int, memorySize> memory{ 0 };
+    std::copy(words.begin(), words.end(), memory.begin());
+    return memory;
+}
+
+//the ir must end exactly where the reference does
+static void requireSameRun(const IrProgram& ir, const std::array<int, memorySize>& image,
+    const std::vector<int>& inputs, uint64_t budget)
+{
+    const EngineRun expected = run_reference(image, inputs, budget);
+    EngineRun actual;
+    actual.termination = run_ssa(ir, inputs, budget, &actual.state, &actual.executed, &actual.outputs);
+    REQUIRE(first_difference(expected, actual).empty());
+}
+
+TEST_CASE("Loops lift with phis at their header", "[lift_to_ssa]") {
+    IrProgram ir = lift_to_ssa(multiplyProgram());
+    REQUIRE(ir.lifted);
+    REQUIRE(ir.blocks.size() == 5);
+    REQUIRE(ir.blocks[2].predecessors == std::vector<size_t>{ 1, 3 });
+    REQUIRE(ir.blocks[2].exit == IrExit::branchZero);
+
+    //the loop-invariant operands a and 1 lose their phis
+    optimize_ssa(ir);
+    REQUIRE(ir.stats.phisRemoved == 2);
+    REQUIRE(format_ir(ir) ==
+        "b0\n"
+        "  v8 = const 1\n"
+        "  v9 = const 0\n"
+        "  jump b1\n"
+        "b1 [0, 2) <- b0\n"
+        "  v0 = read\n"
+        "  v1 = read\n"
+        "  jump b2\n"
+        "b2 [2, 4) <- b1 b3\n"
+        "  v2 = phi v1 v4\n"
+        "  v5 = phi v9 v7\n"
+        "  branchZero v2 b4 b3\n"
+        "b3 [4, 10) <- b2\n"
+        "  v4 = subtract v2 v8\n"
+        "  v7 = add v5 v0\n"
+        "  jump b2\n"
+        "b4 [11, 13) <- b2\n"
+        "  write v5\n"
+        "  halt ac=v2 [40]=v0 [41]=v2 [50]=v5\n");
+
+    requireSameRun(ir, multiplyProgram(), { 6, 7 }, 1000);
+    requireSameRun(ir, multiplyProgram(), { 6, 7 }, 30); //out of budget
+    requireSameRun(ir, multiplyProgram(), { 6 }, 1000); //out of input
+    requireSameRun(ir, multiplyProgram(), { 9999, 2 }, 1000); //overflow
+}
+
+TEST_CASE("Constants fold through branches", "[optimize_ssa]") {
+    //load 3, add 4, store, square, branchNeg over a write, halt
+    std::array<int, memorySize> image = program({ 2020, 3021, 2122, 3322, 4106, 1122, 4300 });
+    image[20] = 3;
+    image[21] = 4;
+
+    IrProgram ir = lift_to_ssa(image);
+    optimize_ssa(ir);
+    REQUIRE(ir.stats.constantsFolded == 2);
+    REQUIRE(ir.stats.branchesFolded == 1);
+    REQUIRE(ir.blocks[3].predecessors == std::vector<size_t>{ 2 });
+    REQUIRE(format_ir(ir).find("add") == std::string::npos);
+    requireSameRun(ir, image, {}, 100);
+
+    //a constant that overflows keeps its fault
+    image[21] = 9999;
+    ir = lift_to_ssa(image);
+    optimize_ssa(ir);
+    REQUIRE(ir.stats.constantsFolded == 0);
+    requireSameRun(ir, image, {}, 100);
+
+    //INT_MIN / -1 faults when folded and when run
+    std::array<int, memorySize> divide = program({ 2020, 3221, 4300 });
+    divide[20] = std::numeric_limits<int>::min();
+    divide[21] = -1;
+    ir = lift_to_ssa(divide);
+    optimize_ssa(ir);
+    REQUIRE(ir.stats.constantsFolded == 0);
+    requireSameRun(ir, divide, {}, 100);
+    const std::array<int, memorySize> readDivide = program({ 1020, 1021, 2020, 3221, 4300 });
+    ir = lift_to_ssa(readDivide);
+    optimize_ssa(ir);
+    requireSameRun(ir, readDivide, { std::numeric_limits<int>::min(), -1 }, 100);
+}
+
+TEST_CASE("Common subexpressions and dead values go", "[optimize_ssa]") {
+    //s1 = x + y, s2 = x + y, write both
+    const std::array<int, memorySize> image = program({ 1020, 1021, 2020, 3021, 2122, 2020, 3021, 2123, 1122, 1123, 4300 });
+    IrProgram ir = lift_to_ssa(image);
+    optimize_ssa(ir);
+    REQUIRE(ir.stats.subexpressionsEliminated == 1);
+    REQUIRE(ir.stats.deadRemoved == 1);
+    REQUIRE(format_ir(ir).find("halt ac=v2 [20]=v0 [21]=v1 [22]=v2 [23]=v2") != std::string::npos);
+    requireSameRun(ir, image, { 5, -8 }, 100);
+    requireSameRun(ir, image, { 9000, 1000 }, 100);
+}
+
+//the lowered image must read, write and halt as the original does
+static EngineRun requireSameEffect(const IrProgram& ir, const std::array<int, memorySize>& image,
+    const std::vector<int>& inputs, std::initializer_list<size_t> cells)
+{
+    const LoweredProgram lowered = lower_ssa(ir);
+    REQUIRE(lowered.lowered);
+    const EngineRun expected = run_reference(image, inputs, 10'000);
+    const EngineRun actual = run_reference(lowered.image, inputs, 10'000);
+    REQUIRE(actual.termination == expected.termination);
+    REQUIRE(actual.outputs == expected.outputs);
+    REQUIRE(actual.state.inputIndex == expected.state.inputIndex);
+    REQUIRE(actual.state.accumulator == expected.state.accumulator);
+    for (size_t cell : cells)
+        REQUIRE(actual.state.memory[cell] == expected.state.memory[cell]);
+    return actual;
+}
+
+TEST_CASE("Optimized ir lowers back to sml", "[lower_ssa]") {
+    IrProgram ir = lift_to_ssa(multiplyProgram());
+    optimize_ssa(ir);
+    requireSameEffect(ir, multiplyProgram(), { 6, 7 }, { 40, 41, 50 });
+    requireSameEffect(ir, multiplyProgram(), { 0, 3 }, { 40, 41, 50 });
+    requireSameEffect(ir, multiplyProgram(), { 9999, 2 }, {}); //overflow
+    requireSameEffect(ir, multiplyProgram(), { 6 }, {}); //out of input
+
+    //folded constants leave only the write and the halt
+    std::array<int, memorySize> image = program({ 2020, 3021, 2122, 3322, 4106, 1122, 4300 });
+    image[20] = 3;
+    image[21] = 4;
+    ir = lift_to_ssa(image);
+    optimize_ssa(ir);
+    const EngineRun folded = requireSameEffect(ir, image, {}, { 22 });
+    REQUIRE(folded.executed < run_reference(image, {}, 100).executed);
+
+    //phis that swap each iteration go through the temp cell
+    std::array<int, memorySize> swap = program({ 1080, 1081, 1082, 2080, 2183, 2081, 2180, 2083, 2181,
+        2082, 3184, 2182, 4214, 4003, 1180, 1181, 4300 });
+    swap[84] = 1;
+    ir = lift_to_ssa(swap);
+    optimize_ssa(ir);
+    requireSameEffect(ir, swap, { 5, 8, 3 }, { 80, 81, 82, 83 });
+    requireSameEffect(ir, swap, { 5, 8, 4 }, { 80, 81, 82, 83 });
+
+    //unlifted images do not lower
+    REQUIRE_FALSE(lower_ssa(lift_to_ssa(program({ 2010, 2103, 1020, 1120, 4300 }))).lowered);
+}
+
+TEST_CASE("Images that cannot lift still run", "[run_ssa]") {
+    //stores a halt over its own write
+    std::array<int, memorySize> image = program({ 2010, 2103, 1020, 1120, 4300 });
+    image[10] = 4300;
+    const IrProgram ir = lift_to_ssa(image);
+    REQUIRE_FALSE(ir.lifted);
+    requireSameRun(ir, image, { 7 }, 100);
+
+    REQUIRE(compare_engines(multiplyProgram(), { 4, 3 }, alternative_engines()).empty());
+    REQUIRE(compare_engines(image, { 4 }, alternative_engines()).empty());
+}
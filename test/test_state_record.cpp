@@ -0,0 +1,114 @@
+#include "catch2/catch.hpp"
+#include "state_record.h"
+
+#include <sstream>
+
+TEST_CASE("Binary state records", "[write_state_binary]") {
+    //run the sample program for a real final state
+    StateRecord record;
+    record.id = 42;
+    load_from_file(record.state.memory, "p1.txt");
+    while (step(record.state, { 4, 5 }) != Command::halt)
+    {
+    }
+
+    //append a batch of records, including a negative instruction word
+    std::stringstream file;
+    for (int i = 0; i < 3; i++)
+    {
+        record.id = i;
+        write_state_binary(file, record);
+    }
+    StateRecord odd;
+    odd.termination = Termination::faulted;
+    odd.state.instructionRegister = -1234;
+    odd.state.operationCode = -1234 / 100;
+    odd.state.operand = -1234 % 100;
+    odd.state.memory[99] = -99999;
+    write_state_binary(file, odd);
+    REQUIRE(file.str().size() == 4 * stateRecordSize);
+
+    //records read back in order with identical contents
+    StateRecord back;
+    for (int i = 0; i < 3; i++)
+    {
+        REQUIRE(read_state_binary(file, back));
+        REQUIRE(back.id == static_cast<uint64_t>(i));
+        REQUIRE(back.termination == Termination::halted);
+        REQUIRE(back.state.memory == record.state.memory);
+        REQUIRE(back.state.accumulator == 9);
+        REQUIRE(back.state.instructionCounter == 6);
+        REQUIRE(back.state.instructionRegister == 4300);
+        REQUIRE(back.state.operationCode == 43);
+    }
+    REQUIRE(read_state_binary(file, back));
+    REQUIRE(back.termination == Termination::faulted);
+    REQUIRE(back.state.operationCode == odd.state.operationCode);
+    REQUIRE(back.state.operand == odd.state.operand);
+    REQUIRE(back.state.memory[99] == -99999);
+    REQUIRE_FALSE(read_state_binary(file, back));
+
+    //truncated record
+    std::stringstream partial(file.str().substr(0, 10));
+    REQUIRE_THROWS_AS(read_state_binary(partial, back), std::runtime_error);
+}
+
+TEST_CASE("JSON state records", "[write_state_json]") {
+    StateRecord record;
+    record.id = 7;
+    record.termination = Termination::budgetExceeded;
+    record.state.accumulator = -12;
+    record.state.memory[0] = 1007;
+    record.state.memory[99] = -5;
+
+    //one line per record
+    std::ostringstream out;
+    write_state_json(out, record);
+    write_state_json(out, record);
+    const std::string text = out.str();
+    const std::string line = text.substr(0, text.find('\n') + 1);
+    REQUIRE(text == line + line);
+    REQUIRE(line.rfind("{\"id\":7,\"termination\":\"budgetExceeded\",\"accumulator\":-12,"
+        "\"instructionCounter\":0,\"instructionRegister\":0,\"operationCode\":0,\"operand\":0,"
+        "\"memory\":[1007,0,", 0) == 0);
+    REQUIRE(line.find(",0,-5]}\n") != std::string::npos);
+}
+
+TEST_CASE("Sparse state records", "[write_diff_binary]") {
+    //run the sample program and keep its loaded image
+    std::array<int, memorySize> image{ 0 };
+    load_from_file(image, "p1.txt");
+    StateRecord record;
+    record.state.memory = image;
+    while (step(record.state, { 4, 5 }) != Command::halt)
+    {
+    }
+
+    //only the two inputs and the sum changed
+    const std::vector<CellChange> changes = diff_memory(image, record.state.memory);
+    REQUIRE(changes.size() == 3);
+    REQUIRE(changes[0].address == 7);
+    REQUIRE(changes[2].value == 9);
+
+    //binary record is a few bytes and rebuilds the full state
+    std::stringstream file;
+    write_diff_binary(file, record, image);
+    write_diff_binary(file, StateRecord{ 1, Termination::faulted, { image } }, image);
+    REQUIRE(file.str().size() < stateRecordSize / 4);
+
+    StateRecord back;
+    REQUIRE(read_diff_binary(file, image, back));
+    REQUIRE(back.state.memory == record.state.memory);
+    REQUIRE(back.state.accumulator == 9);
+    REQUIRE(back.state.instructionRegister == 4300);
+    REQUIRE(read_diff_binary(file, image, back));
+    REQUIRE(back.id == 1);
+    REQUIRE(back.termination == Termination::faulted);
+    REQUIRE(back.state.memory == image);
+    REQUIRE_FALSE(read_diff_binary(file, image, back));
+
+    //json lists the changed cells only
+    std::ostringstream json;
+    write_diff_json(json, record, image);
+    REQUIRE(json.str().find(",\"changes\":[[7,4],[8,5],[9,9]]}\n") != std::string::npos);
+}
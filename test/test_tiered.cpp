@@ -0,0 +1,68 @@
+#include "catch2/catch.hpp"
+#include "differential.h"
+#include "test_programs.h"
+#include "tiered.h"
+
+#include <limits>
+
+TEST_CASE("Programs are promoted as their loops get hot", "[TieredEngine]") {
+    TieredEngine engine({ 10, 100 });
+    const std::array<int, memorySize> cold = countdownProgram(5);
+    REQUIRE(engine.profile(cold) == nullptr);
+
+    //five backward branches a run, the second run crosses into decoded
+    REQUIRE(run_tiered_engine(engine, cold, {}, 1000).state.memory[21] == 15);
+    REQUIRE(engine.profile(cold)->tier == Tier::interpreted);
+    REQUIRE(engine.profile(cold)->loopCounts[0] == 5);
+    run_tiered_engine(engine, cold, {}, 1000);
+    REQUIRE(engine.profile(cold)->tier == Tier::decoded);
+    REQUIRE(engine.profile(cold)->runs == 2);
+
+    //a hot program goes through both tiers within its first run
+    const std::array<int, memorySize> hot = countdownProgram(140);
+    const EngineRun run = run_tiered_engine(engine, hot, {}, 100'000);
+    REQUIRE(engine.profile(hot)->tier == Tier::optimized);
+    REQUIRE(engine.profile(hot)->summaries.loops.size() == 1);
+    REQUIRE(first_difference(run_reference(hot, {}, 100'000), run).empty());
+
+    //profiles are per program
+    REQUIRE(engine.profile(cold)->tier == Tier::decoded);
+}
+
+TEST_CASE("Promotion keeps every result", "[TieredEngine]") {
+    //every budget cut lands at a different point of the promotions
+    for (uint64_t budget = 0; budget < 300; budget += 7)
+    {
+        TieredEngine engine({ 3, 12 });
+        for (int n : { 20, 141, 0 })
+        {
+            const std::array<int, memorySize> image = countdownProgram(n);
+            REQUIRE(first_difference(run_reference(image, {}, budget), run_tiered_engine(engine, image, {}, budget)).empty());
+        }
+    }
+
+    //a loop that stores into its own code is decoded again
+    std::array<int, memorySize> selfModifying{ 0 };
+    selfModifying[0] = 1030; //loop: read a word
+    selfModifying[1] = 2030; //load it
+    selfModifying[2] = 2103; //store it as the next instruction
+    selfModifying[3] = 0; //overwritten
+    selfModifying[4] = 4000;
+    TieredEngine engine({ 1, 2 });
+    const std::vector<int> inputs{ 2031, 4000, 2032, 1131, 4000, 4300 };
+    REQUIRE(first_difference(run_reference(selfModifying, inputs, 1000), run_tiered_engine(engine, selfModifying, inputs, 1000)).empty());
+    REQUIRE(first_difference(run_reference(selfModifying, { 3399 }, 1000), run_tiered_engine(engine, selfModifying, { 3399 }, 1000)).empty());
+    REQUIRE(compare_engines(countdownProgram(60), {}, alternative_engines()).empty());
+
+    //INT_MIN / -1 read from inputs faults in the decoded tier
+    std::array<int, memorySize> divide{ 0 };
+    divide[0] = 1010;
+    divide[1] = 1011;
+    divide[2] = 2010;
+    divide[3] = 3211;
+    divide[4] = 4300;
+    TieredEngine decodedFirst({ 0, 0 });
+    const std::vector<int> extremes{ std::numeric_limits<int>::min(), -1 };
+    REQUIRE(first_difference(run_reference(divide, extremes, 100), run_tiered_engine(decodedFirst, divide, extremes, 100)).empty());
+    REQUIRE(decodedFirst.profile(divide)->tier == Tier::optimized);
+}
@@ -0,0 +1,95 @@
+#include "catch2/catch.hpp"
+#include "trace.h"
+
+#include <thread>
+
+TEST_CASE("Trace ring buffer", "[TraceRing]") {
+    TraceRing ring(3); //rounds up to 4
+    TraceEntry entry;
+    for (int i = 0; i < 4; i++)
+    {
+        entry.instructionRegister = i;
+        REQUIRE(ring.push(entry));
+    }
+    REQUIRE_FALSE(ring.push(entry));
+
+    //entries come out in order and free their slots
+    TraceEntry out[8];
+    REQUIRE(ring.pop(out, 3) == 3);
+    REQUIRE(out[2].instructionRegister == 2);
+    REQUIRE(ring.push(entry));
+    REQUIRE(ring.pop(out, 8) == 2);
+    REQUIRE(ring.pop(out, 8) == 0);
+
+    //one producer and one consumer thread
+    TraceRing shared(1024);
+    std::thread producer([&] {
+        TraceEntry e;
+        for (int i = 0; i < 100000; i++)
+        {
+            e.instructionRegister = i;
+            while (!shared.push(e))
+                std::this_thread::yield();
+        }
+    });
+    int expected = 0;
+    while (expected < 100000)
+    {
+        const size_t count = shared.pop(out, 8);
+        if (count == 0)
+            std::this_thread::yield();
+        for (size_t i = 0; i < count; i++)
+            REQUIRE(out[i].instructionRegister == expected++);
+    }
+    producer.join();
+}
+
+TEST_CASE("Traced execution", "[execute_traced]") {
+    std::array<int, memorySize> memory{ 0 };
+    int accumulator{ 0 };
+    size_t instructionCounter{ 0 };
+    int instructionRegister{ 0 };
+    size_t operationCode{ 0 };
+    size_t operand{ 0 };
+    load_from_file(memory, "p1.txt");
+
+    //small ring forces the machine to wait on the writer
+    {
+        TraceRecorder recorder("trace.bin", 2);
+        execute_traced(memory, &accumulator, &instructionCounter, &instructionRegister,
+            &operationCode, &operand, { 4, 5 }, recorder);
+    }
+    REQUIRE(memory[9] == 9);
+
+    //one entry per instruction with writes and accumulator changes
+    std::ifstream in("trace.bin", std::ios::binary);
+    std::vector<TraceEntry> entries;
+    TraceEntry entry;
+    while (read_trace_entry(in, entry))
+        entries.push_back(entry);
+    REQUIRE(entries.size() == 7);
+    REQUIRE(entries[0].instructionRegister == 1007);
+    REQUIRE(entries[0].writeAddress == 7);
+    REQUIRE(entries[0].writeValue == 4);
+    REQUIRE(entries[3].accumulatorBefore == 4);
+    REQUIRE(entries[3].accumulatorAfter == 9);
+    REQUIRE(entries[3].writeAddress == noWrite);
+    REQUIRE(entries[4].writeAddress == 9);
+    REQUIRE(entries[6].instructionCounter == 6);
+    REQUIRE(entries[6].instructionRegister == 4300);
+
+    //a fault is recorded and still thrown
+    memory.fill(0);
+    memory[0] = 3205;
+    instructionCounter = 0;
+    {
+        TraceRecorder recorder("fault.bin");
+        REQUIRE_THROWS_AS(execute_traced(memory, &accumulator, &instructionCounter, &instructionRegister,
+            &operationCode, &operand, {}, recorder), std::runtime_error);
+    }
+    std::ifstream faultIn("fault.bin", std::ios::binary);
+    REQUIRE(read_trace_entry(faultIn, entry));
+    REQUIRE(entry.faulted);
+    REQUIRE(entry.instructionRegister == 3205);
+    REQUIRE_FALSE(read_trace_entry(faultIn, entry));
+}
@@ -0,0 +1,139 @@
+#include "catch2/catch.hpp"
+#include "differential.h"
+#include "tiered.h"
+#include "trace_compiler.h"
+
+#include <limits>
+
+//multiplies mem[31] by mem[30] while counting mem[30] down to zero
+static std::array<int, memorySize> factorialProgram(int n)
+{
+    std::array<int, memorySize> memory{ 0 };
+    memory[0] = 2030; //loop: load n
+    memory[1] = 4209; //zero ends the loop
+    memory[2] = 2031; //product *= n
+    memory[3] = 3330;
+    memory[4] = 2131;
+    memory[5] = 2030; //n -= 1
+    memory[6] = 3132;
+    memory[7] = 2130;
+    memory[8] = 4000;
+    memory[9] = 4300;
+    memory[30] = n;
+    memory[31] = 1;
+    memory[32] = 1;
+    return memory;
+}
+
+//flips mem[43] between 1 and -1 each iteration and counts the positive
+//ones in mem[44], so the loop takes its two paths in turn
+static std::array<int, memorySize> alternatingProgram(int n)
+{
+    std::array<int, memorySize> memory{ 0 };
+    memory[0] = 2040; //loop: load n
+    memory[1] = 4212; //zero ends the loop
+    memory[2] = 3141; //n -= 1
+    memory[3] = 2140;
+    memory[4] = 2042; //t = 0 - t
+    memory[5] = 3143;
+    memory[6] = 2143;
+    memory[7] = 4111; //negative skips the count
+    memory[8] = 2044; //count += 1
+    memory[9] = 3041;
+    memory[10] = 2144;
+    memory[11] = 4000;
+    memory[12] = 4300;
+    memory[40] = n;
+    memory[41] = 1;
+    memory[43] = 1;
+    return memory;
+}
+
+TEST_CASE("Loop paths compile into superinstructions with guards", "[TraceCompiler]") {
+    const std::array<int, memorySize> image = factorialProgram(7);
+    const Trace trace = compile_trace(0, { 0, 1, 2, 3, 4, 5, 6, 7, 8 }, image);
+    REQUIRE(trace.compiled);
+    REQUIRE(trace.ops.size() == 4);
+    REQUIRE(trace.ops[0].kind == TraceOpKind::load);
+    REQUIRE(trace.ops[1].kind == TraceOpKind::guard);
+    REQUIRE_FALSE(trace.ops[1].taken);
+    REQUIRE(trace.ops[2].kind == TraceOpKind::loadArithmeticStore);
+    REQUIRE(trace.ops[2].command == Command::multiply);
+    REQUIRE(trace.ops[3].kind == TraceOpKind::loadArithmeticStore);
+    REQUIRE(trace.stores == std::vector<size_t>{ 31, 30 });
+    REQUIRE(trace.closing == 4000);
+
+    //paths that are not one iteration of a loop stay uncompiled
+    REQUIRE_FALSE(compile_trace(0, { 0, 1, 2 }, image).compiled);
+    REQUIRE_FALSE(compile_trace(0, { 0, 1, 9 }, image).compiled);
+    std::array<int, memorySize> selfModifying = image;
+    selfModifying[7] = 2106;
+    REQUIRE_FALSE(compile_trace(0, { 0, 1, 2, 3, 4, 5, 6, 7, 8 }, selfModifying).compiled);
+
+    //the guard leaves on the iteration that finds n at zero
+    MachineState state;
+    state.memory = image;
+    const uint64_t executed = run_trace(trace, state.memory, &state.accumulator, &state.instructionCounter,
+        &state.instructionRegister, 1000, nullptr);
+    REQUIRE(executed == 7 * 9 + 1);
+    REQUIRE(state.instructionCounter == 1);
+    REQUIRE(state.accumulator == 0);
+    REQUIRE(state.instructionRegister == 2030);
+    REQUIRE(state.memory[31] == 5040);
+
+    //INT_MIN / -1 leaves the trace as a fault instead of trapping
+    std::array<int, memorySize> divide{ 0 };
+    divide[0] = 2020;
+    divide[1] = 3221;
+    divide[2] = 2122;
+    divide[3] = 4000;
+    const Trace divideTrace = compile_trace(0, { 0, 1, 2, 3 }, divide);
+    REQUIRE(divideTrace.compiled);
+    MachineState extremes;
+    extremes.memory = divide;
+    extremes.memory[20] = std::numeric_limits<int>::min();
+    extremes.memory[21] = -1;
+    REQUIRE(run_trace(divideTrace, extremes.memory, &extremes.accumulator, &extremes.instructionCounter,
+        &extremes.instructionRegister, 1000, nullptr) == 0);
+    REQUIRE(extremes.instructionCounter == 0);
+    REQUIRE(extremes.memory[22] == 0);
+}
+
+TEST_CASE("Traced loops end every run as the interpreter does", "[TraceCompiler]") {
+    //budget cuts fall inside iterations, guards fail every other
+    //iteration and the multiply faults inside the trace
+    for (uint64_t budget = 0; budget < 400; budget += 3)
+    {
+        TieredEngine engine({ 1, 2, 2 });
+        for (const auto& image : { alternatingProgram(30), factorialProgram(7), factorialProgram(9) })
+        {
+            REQUIRE(first_difference(run_reference(image, {}, budget), run_tiered_engine(engine, image, {}, budget)).empty());
+            REQUIRE(first_difference(run_reference(image, {}, budget), run_tiered_engine(engine, image, {}, budget)).empty());
+        }
+    }
+
+    TieredEngine engine({ 1, 2, 2 });
+    const std::array<int, memorySize> image = alternatingProgram(30);
+    run_tiered_engine(engine, image, {}, 1000);
+    REQUIRE(engine.profile(image)->traceAt[0] != SIZE_MAX);
+    REQUIRE(engine.profile(image)->traces.size() == 1);
+
+    //a read into the traced loop retires its trace for the run
+    std::array<int, memorySize> overwritten{ 0 };
+    overwritten[0] = 2050; //loop: load n
+    overwritten[1] = 4206; //zero leaves the loop
+    overwritten[2] = 3151; //n -= 1
+    overwritten[3] = 2150;
+    overwritten[4] = 4000;
+    overwritten[6] = 1001; //read over the test
+    overwritten[7] = 4000;
+    overwritten[9] = 4300;
+    overwritten[50] = 10;
+    overwritten[51] = 1;
+    TieredEngine traced({ 1, 2, 2 });
+    for (int run = 0; run < 2; ++run)
+        REQUIRE(first_difference(run_reference(overwritten, { 4109 }, 1000),
+            run_tiered_engine(traced, overwritten, { 4109 }, 1000)).empty());
+    REQUIRE(traced.profile(overwritten)->traces.size() == 1);
+    REQUIRE(compare_engines(alternatingProgram(25), {}, alternative_engines()).empty());
+}
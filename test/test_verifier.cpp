@@ -0,0 +1,121 @@
+#include "catch2/catch.hpp"
+#include "differential.h"
+#include "interpreter.h"
+#include "test_programs.h"
+#include "verifier.h"
+
+#include <limits>
+
+//the unchecked run must end exactly where the checked one does
+static void requireSameRun(const std::array<int, memorySize>& image, const std::vector<int>& inputs, uint64_t budget)
+{
+    MachineState expected;
+    expected.memory = image;
+    uint64_t expectedCount{ 0 };
+    NullObserver observer;
+    const Termination termination = run(expected, inputs, budget, &expectedCount, observer);
+
+    MachineState actual;
+    actual.memory = image;
+    uint64_t actualCount{ 0 };
+    REQUIRE(run_unchecked(actual, inputs, budget, &actualCount, verify_program(image)) == termination);
+    REQUIRE(actualCount == expectedCount);
+    REQUIRE(actual == expected);
+}
+
+TEST_CASE("Verifier accepts well-formed programs", "[verify_program]") {
+    const Verification verification = verify_program(multiplyProgram());
+    REQUIRE(verification.verified);
+    REQUIRE(verification.issues.empty());
+    REQUIRE(verification.code.count() == 12);
+    REQUIRE_FALSE(verification.code[10]);
+    REQUIRE(verification.codeWrites.none());
+
+    //data after the halt is never checked
+    std::array<int, memorySize> memory = multiplyProgram();
+    memory[13] = -5;
+    memory[14] = 9999;
+    REQUIRE(verify_program(memory).verified);
+}
+
+TEST_CASE("Verifier rejects unsafe instructions", "[verify_program]") {
+    std::array<int, memorySize> memory = multiplyProgram();
+    memory[6] = 5050; //unknown opcode
+    memory[11] = -1150; //negative word
+    Verification verification = verify_program(memory);
+    REQUIRE_FALSE(verification.verified);
+    REQUIRE(verification.issues.size() == 2);
+    REQUIRE(verification.issues[0].address == 6);
+    REQUIRE(verification.issues[0].error == VerifyError::invalidOpcode);
+    REQUIRE(verification.issues[1].address == 11);
+    REQUIRE(verification.issues[1].error == VerifyError::negativeWord);
+
+    //straight code running into the end of memory
+    memory = { 0 };
+    memory[0] = 4097;
+    memory[97] = 2010;
+    memory[98] = 3010;
+    memory[99] = 2110;
+    verification = verify_program(memory);
+    REQUIRE(verification.issues.size() == 1);
+    REQUIRE(verification.issues[0].address == 99);
+    REQUIRE(verification.issues[0].error == VerifyError::fallsOffMemory);
+}
+
+TEST_CASE("Writes into code are flagged", "[verify_program]") {
+    //stores a halt over the write at address 3
+    std::array<int, memorySize> memory{ 0 };
+    memory[0] = 2010;
+    memory[1] = 2103;
+    memory[2] = 1020; //read into data
+    memory[3] = 1120;
+    memory[4] = 4300;
+    memory[10] = 4300;
+    const Verification verification = verify_program(memory);
+    REQUIRE(verification.verified);
+    REQUIRE(verification.codeWrites.count() == 1);
+    REQUIRE(verification.codeWrites[1]);
+
+    requireSameRun(memory, { 7 }, 100);
+}
+
+TEST_CASE("Unchecked runs match the checked interpreter", "[run_unchecked]") {
+    const std::array<int, memorySize> image = multiplyProgram();
+    requireSameRun(image, { 6, 7 }, 1000);
+    requireSameRun(image, { 6, 7 }, 20); //out of budget
+    requireSameRun(image, { 6 }, 1000); //out of input
+    requireSameRun(image, { 9999, 2 }, 1000); //overflow
+
+    //division by zero and a program that does not verify
+    std::array<int, memorySize> memory{ 0 };
+    memory[0] = 2010;
+    memory[1] = 3211;
+    memory[10] = 5;
+    requireSameRun(memory, {}, 100);
+    memory[1] = 9911;
+    requireSameRun(memory, {}, 100);
+
+    //INT_MIN / -1 from inputs faults rather than trapping
+    std::array<int, memorySize> extremes{ 0 };
+    extremes[0] = 1010;
+    extremes[1] = 1011;
+    extremes[2] = 2010;
+    extremes[3] = 3211;
+    extremes[4] = 4300;
+    requireSameRun(extremes, { std::numeric_limits<int>::min(), -1 }, 100);
+
+    //resuming from the middle of a run
+    MachineState expected;
+    expected.memory = image;
+    uint64_t count{ 0 };
+    NullObserver observer;
+    run(expected, { 3, 4 }, 9, &count, observer);
+    MachineState actual = expected;
+    run(expected, { 3, 4 }, 1000, &count, observer);
+    run_unchecked(actual, { 3, 4 }, 1000, &count, verify_program(image));
+    REQUIRE(actual == expected);
+    REQUIRE(expected.memory[50] == 12);
+
+    //agrees with the reference under differential testing
+    REQUIRE(compare_engines(image, { 5, 8 }, alternative_engines()).empty());
+}